@@ -1,79 +1,769 @@
 /*
-Kosaraju's algorithm for finding strongly connected components (SCCs) in directed graphs.
+Strongly connected components (SCCs) in directed graphs.
 
 A strongly connected component is a maximal set of vertices where every vertex is
-reachable from every other vertex in the set. Uses two DFS passes.
+reachable from every other vertex in the set. Nodes are mapped to dense ids, the edges are
+frozen into a CSR (compressed sparse row) array once, and components are found with a single
+iterative Tarjan pass, so deep graphs cannot overflow the call stack and no transpose graph is
+stored. The class keeps its historical name; Kosaraju's two-pass algorithm needs the transpose.
 
-Time complexity: O(V + E) where V is vertices and E is edges.
-Space complexity: O(V + E) for graph representation and auxiliary structures.
+Optionally the condensation DAG (deduplicated edges between components, in topological order,
+plus component sizes) is emitted in CSR form during the same pass.
+
+compute_components_parallel finds the same components with multiple threads using trimming and
+forward-backward reachability (parallel BFS from one pivot per open partition), handing the
+rest to a sequential Tarjan pass once rounds stop making progress.
+
+IncrementalSCC maintains the components under edge insertions without recomputation.
+
+ReachabilityIndex answers "can u reach v" by the transitive closure of the condensation, one
+bitset row per component, built in reverse topological order 64 bits at a time: O(1) per query
+after O(C * E_dag / 64) preprocessing, where C is the number of components.
+
+Time complexity: O(V + E) where V is vertices and E is edges, plus O(E log V) to map node keys.
+Space complexity: O(V + E) for the edge list, CSR arrays and per-node state.
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <map>
-#include <set>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+struct Condensation {
+    /* DAG of components in CSR form; ids are in topological order, so every edge goes up. */
+    std::vector<int> offsets, targets;  // Out-edges of c are targets[offsets[c]..offsets[c + 1])
+    std::vector<int> sizes;             // Nodes per component
+};
+
+template <typename F>
+void parallel_chunks(int threads, int n, const F& f) {
+    /* Run f(begin, end) on contiguous chunks of [0, n); small ranges run inline. */
+    if (threads <= 1 || n < 4096) {
+        f(0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        int begin = (long long)n * t / threads, end = (long long)n * (t + 1) / threads;
+        workers.emplace_back([&f, begin, end] { f(begin, end); });
+    }
+    for (auto& w : workers) { w.join(); }
+}
+
+template <typename F>
+std::vector<int> parallel_expand(int threads, const std::vector<int>& items, const F& f) {
+    /* Call f(item, out) for every item in parallel and concatenate the outputs. */
+    std::mutex lock;
+    std::vector<int> result;
+    parallel_chunks(threads, items.size(), [&](int begin, int end) {
+        std::vector<int> out;
+        for (int i = begin; i < end; i++) { f(items[i], out); }
+        std::lock_guard<std::mutex> guard(lock);
+        result.insert(result.end(), out.begin(), out.end());
+    });
+    return result;
+}
+
+std::vector<int> parallel_scc(int n, const std::vector<int>& offsets,
+                              const std::vector<int>& targets, int threads) {
+    /*
+    Forward-backward SCC with trimming. All open partitions (colors) are processed together:
+    trim vertices without in- or out-edges inside their color, then mutual pairs closed to
+    incoming or outgoing edges (size-2 trim), pick the smallest vertex of each color as pivot,
+    run parallel BFS forward and backward from all pivots at once, then FW and BW intersect in
+    the pivot's SCC and the rest splits into three new colors.
+
+    A round that removes less than a quarter of the active vertices means the rest consists of
+    many small SCCs (a chain of 2-cycles would otherwise take one round per SCC), so the
+    remaining partitions are finished by a sequential iterative Tarjan over same-color edges.
+    That bounds the parallel phase to O(log V) rounds.
+    Returns a representative vertex of each vertex's component.
+    */
+    std::vector<int> in_offsets(n + 1, 0), sources(targets.size());
+    for (int t : targets) { in_offsets[t + 1]++; }
+    for (int i = 0; i < n; i++) { in_offsets[i + 1] += in_offsets[i]; }
+    std::vector<int> pos(in_offsets.begin(), in_offsets.end() - 1);
+    for (int u = 0; u < n; u++) {
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) { sources[pos[targets[e]]++] = u; }
+    }
+
+    std::vector<std::atomic<int>> comp(n), in_deg(n), out_deg(n), pivot(3 * (size_t)n);
+    std::vector<std::atomic<char>> fw(n), bw(n);
+    std::vector<int> color(n, 0), active(n);
+    for (int v = 0; v < n; v++) {
+        comp[v] = -1;
+        active[v] = v;
+    }
+    for (auto& p : pivot) { p = INT_MAX; }
+
+    auto same = [&](int u, int v) { return comp[u].load() == -1 && color[u] == color[v]; };
+
+    while (!active.empty()) {
+        size_t round_start = active.size();
+        // Trim: repeatedly remove vertices with no in- or out-neighbour of their own color
+        std::vector<int> frontier = parallel_expand(threads, active, [&](int v, auto& out) {
+            int din = 0, dout = 0;
+            for (int e = in_offsets[v]; e < in_offsets[v + 1]; e++) { din += same(sources[e], v); }
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) { dout += same(targets[e], v); }
+            in_deg[v] = din;
+            out_deg[v] = dout;
+            if (din == 0 || dout == 0) { out.push_back(v); }
+        });
+        for (int v : frontier) { comp[v] = v; }
+        while (!frontier.empty()) {
+            frontier = parallel_expand(threads, frontier, [&](int v, auto& out) {
+                auto release = [&](int w, std::atomic<int>& deg) {
+                    if (comp[w].load() != -1 || color[w] != color[v]) { return; }
+                    int expected = -1;
+                    if (--deg == 0 && comp[w].compare_exchange_strong(expected, w)) {
+                        out.push_back(w);
+                    }
+                };
+                for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                    release(targets[e], in_deg[targets[e]]);
+                }
+                for (int e = in_offsets[v]; e < in_offsets[v + 1]; e++) {
+                    release(sources[e], out_deg[sources[e]]);
+                }
+            });
+        }
+
+        // Size-2 trim: u <-> v where each is the other's only in-neighbour (or out-neighbour)
+        auto only = [&](int v, const std::vector<int>& offs, const std::vector<int>& adj) {
+            for (int e = offs[v]; e < offs[v + 1]; e++) {
+                if (same(adj[e], v)) { return adj[e]; }
+            }
+            return -1;
+        };
+        parallel_chunks(threads, active.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int v = active[i];
+                if (comp[v].load() != -1) { continue; }
+                for (bool in : {true, false}) {
+                    const auto& offs = in ? in_offsets : offsets;
+                    const auto& adj = in ? sources : targets;
+                    auto& deg = in ? in_deg : out_deg;
+                    if (deg[v] != 1) { continue; }
+                    int u = only(v, offs, adj);
+                    if (u > v && deg[u] == 1 && only(u, offs, adj) == v) {
+                        comp[v] = v;
+                        comp[u] = v;
+                    }
+                }
+            }
+        });
+
+        std::vector<int> remaining = parallel_expand(threads, active, [&](int v, auto& out) {
+            if (comp[v].load() == -1) { out.push_back(v); }
+        });
+        if (remaining.size() * 4 > round_start * 3) {  // Too little progress: finish sequentially
+            active.swap(remaining);
+            break;
+        }
+        active.swap(remaining);
+        if (active.empty()) { break; }
+
+        // One pivot per color: the smallest remaining vertex
+        parallel_chunks(threads, active.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int v = active[i];
+                fw[v] = bw[v] = 0;
+                int cur = pivot[color[v]].load();
+                while (v < cur && !pivot[color[v]].compare_exchange_weak(cur, v)) {}
+            }
+        });
+        std::vector<int> pivots = parallel_expand(threads, active, [&](int v, auto& out) {
+            if (pivot[color[v]].load() == v) { out.push_back(v); }
+        });
+
+        auto bfs = [&](std::vector<std::atomic<char>>& mark, const std::vector<int>& offs,
+                       const std::vector<int>& adj) {
+            for (int p : pivots) { mark[p] = 1; }
+            std::vector<int> level = pivots;
+            while (!level.empty()) {
+                level = parallel_expand(threads, level, [&](int v, auto& out) {
+                    for (int e = offs[v]; e < offs[v + 1]; e++) {
+                        int w = adj[e];
+                        if (same(w, v) && !mark[w].load() && !mark[w].exchange(1)) {
+                            out.push_back(w);
+                        }
+                    }
+                });
+            }
+        };
+        bfs(fw, offsets, targets);
+        bfs(bw, in_offsets, sources);
+
+        // FW and BW meet in the pivot's SCC; other vertices move to one of three new colors
+        std::vector<int> next_color(active.size());
+        parallel_chunks(threads, active.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int v = active[i], p = pivot[color[v]].load();
+                if (fw[v] && bw[v]) {
+                    comp[v] = p;
+                } else {
+                    next_color[i] = 3 * p + (fw[v] ? 1 : 0) + (bw[v] ? 2 : 0);
+                }
+            }
+        });
+        for (int p : pivots) { pivot[color[p]] = INT_MAX; }
+        parallel_chunks(threads, active.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; i++) { color[active[i]] = next_color[i]; }
+        });
+        remaining = parallel_expand(threads, active, [&](int v, auto& out) {
+            if (comp[v].load() == -1) { out.push_back(v); }
+        });
+        active.swap(remaining);
+        if (active.size() * 4 > round_start * 3) { break; }
+    }
+
+    // Sequential iterative Tarjan over what is left; SCCs never span colors, so only edges
+    // inside a color are followed, and finished vertices drop out of same()
+    std::vector<int> index(n, -1), low(n), edge_pos(n), stack, call;
+    int counter = 0;
+    for (int root : active) {
+        if (index[root] != -1 || comp[root].load() != -1) { continue; }
+        index[root] = low[root] = counter++;
+        edge_pos[root] = offsets[root];
+        stack.push_back(root);
+        call.push_back(root);
+        while (!call.empty()) {
+            int v = call.back();
+            if (edge_pos[v] < offsets[v + 1]) {
+                int w = targets[edge_pos[v]++];
+                if (!same(w, v)) { continue; }
+                if (index[w] == -1) {  // Tree edge: descend
+                    index[w] = low[w] = counter++;
+                    edge_pos[w] = offsets[w];
+                    stack.push_back(w);
+                    call.push_back(w);
+                } else {  // w is still on the stack
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            call.pop_back();
+            if (!call.empty()) { low[call.back()] = std::min(low[call.back()], low[v]); }
+            if (low[v] == index[v]) {  // v is the root: pop its component off the stack
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    comp[w] = v;
+                } while (w != v);
+            }
+        }
+    }
+
+    std::vector<int> result(n);
+    for (int v = 0; v < n; v++) { result[v] = comp[v]; }
+    return result;
+}
+
 template <typename NodeT>
 class KosarajuSCC {
   private:
-    std::map<NodeT, std::vector<NodeT>> graph;
-    std::map<NodeT, std::vector<NodeT>> transpose;
-
-    void dfs1(NodeT node, std::set<NodeT>& visited, std::vector<NodeT>& finish_order) {
-        visited.insert(node);
-        if (graph.find(node) != graph.end()) {
-            for (const auto& neighbor : graph[node]) {
-                if (visited.find(neighbor) == visited.end()) {
-                    dfs1(neighbor, visited, finish_order);
+    std::map<NodeT, int> ids;  // Dense id per node, in order of first appearance
+    std::vector<NodeT> nodes;  // nodes[id]
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> offsets, targets;  // CSR: out-edges of v are targets[offsets[v]..]
+    std::vector<int> comp;              // comp[id], components numbered in topological order
+    int components = 0;
+    Condensation dag;
+
+    int id_of(const NodeT& node) {
+        auto [it, inserted] = ids.try_emplace(node, nodes.size());
+        if (inserted) { nodes.push_back(node); }
+        return it->second;
+    }
+
+    void build_csr() {
+        int n = nodes.size();
+        offsets.assign(n + 1, 0);
+        for (const auto& [u, v] : edges) { offsets[u + 1]++; }
+        for (int i = 0; i < n; i++) { offsets[i + 1] += offsets[i]; }
+        targets.resize(edges.size());
+        std::vector<int> pos(offsets.begin(), offsets.end() - 1);
+        for (const auto& [u, v] : edges) { targets[pos[u]++] = v; }
+    }
+
+    void tarjan(bool with_dag) {
+        int n = nodes.size();
+        std::vector<int> index(n, -1), low(n), edge_pos(n), stack, call;
+        std::vector<int> seen;  // seen[c] = last component that emitted an edge to c
+        comp.assign(n, -1);
+        components = 0;
+        dag = Condensation{{0}, {}, {}};
+        int counter = 0;
+
+        for (int root = 0; root < n; root++) {
+            if (index[root] != -1) { continue; }
+            call.push_back(root);
+            index[root] = low[root] = counter++;
+            edge_pos[root] = offsets[root];
+            stack.push_back(root);
+
+            while (!call.empty()) {
+                int v = call.back();
+                if (edge_pos[v] < offsets[v + 1]) {
+                    int w = targets[edge_pos[v]++];
+                    if (index[w] == -1) {  // Tree edge: descend
+                        index[w] = low[w] = counter++;
+                        edge_pos[w] = offsets[w];
+                        stack.push_back(w);
+                        call.push_back(w);
+                    } else if (comp[w] == -1) {  // w is still on the stack
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+
+                call.pop_back();
+                if (!call.empty()) { low[call.back()] = std::min(low[call.back()], low[v]); }
+                if (low[v] == index[v]) {  // v is the root: pop its component off the stack
+                    int top = stack.size();
+                    while (stack.back() != v) { stack.pop_back(); }
+                    int begin = stack.size() - 1;
+                    for (int i = begin; i < top; i++) { comp[stack[i]] = components; }
+                    if (with_dag) {
+                        // All successors are finished, so the component's out-edges are final
+                        seen.push_back(-1);
+                        for (int i = begin; i < top; i++) {
+                            int u = stack[i];
+                            for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+                                int c = comp[targets[e]];
+                                if (c != components && seen[c] != components) {
+                                    seen[c] = components;
+                                    dag.targets.push_back(c);
+                                }
+                            }
+                        }
+                        dag.offsets.push_back(dag.targets.size());
+                        dag.sizes.push_back(top - begin);
+                    }
+                    stack.resize(begin);
+                    components++;
                 }
             }
         }
-        finish_order.push_back(node);
+
+        // Tarjan emits components in reverse topological order
+        for (int& c : comp) { c = components - 1 - c; }
+        if (with_dag) { reverse_dag(); }
     }
 
-    void dfs2(NodeT node, std::set<NodeT>& visited, std::vector<NodeT>& scc) {
-        visited.insert(node);
-        scc.push_back(node);
-        if (transpose.find(node) != transpose.end()) {
-            for (const auto& neighbor : transpose[node]) {
-                if (visited.find(neighbor) == visited.end()) { dfs2(neighbor, visited, scc); }
+    void reverse_dag() {
+        Condensation topo{{0}, {}, {}};
+        for (int t = components - 1; t >= 0; t--) {
+            for (int e = dag.offsets[t]; e < dag.offsets[t + 1]; e++) {
+                topo.targets.push_back(components - 1 - dag.targets[e]);
             }
+            topo.offsets.push_back(topo.targets.size());
+            topo.sizes.push_back(dag.sizes[t]);
         }
+        dag = std::move(topo);
     }
 
   public:
     void add_edge(NodeT u, NodeT v) {
-        graph[u].push_back(v);
-        transpose[v].push_back(u);
-        graph.try_emplace(v, std::vector<NodeT>{});
-        transpose.try_emplace(u, std::vector<NodeT>{});
+        int a = id_of(u);
+        int b = id_of(v);
+        edges.push_back({a, b});
+    }
+
+    int compute_components(bool build_condensation = false) {
+        /*
+        Run Tarjan over the CSR graph and return the number of components. With
+        build_condensation, the deduplicated component DAG is emitted during the same pass.
+        */
+        build_csr();
+        tarjan(build_condensation);
+        return components;
+    }
+
+    int compute_components_parallel(int threads) {
+        /*
+        Same partition as compute_components, found by parallel trimming and forward-backward
+        reachability. Component ids are dense but not in topological order, and no
+        condensation is built.
+        */
+        build_csr();
+        std::vector<int> rep = parallel_scc(nodes.size(), offsets, targets, threads);
+        std::vector<int> id(nodes.size(), -1);
+        components = 0;
+        for (int v = 0; v < (int)nodes.size(); v++) {
+            if (id[rep[v]] == -1) { id[rep[v]] = components++; }
+        }
+        comp.resize(nodes.size());
+        for (int v = 0; v < (int)nodes.size(); v++) { comp[v] = id[rep[v]]; }
+        dag = Condensation{};
+        return components;
+    }
+
+    const Condensation& get_condensation() const {
+        /* Requires compute_components(true). */
+        return dag;
+    }
+
+    const std::vector<int>& component_ids() const {
+        /* Flat component id per dense node id, in topological order of the condensation. */
+        return comp;
+    }
+
+    const std::vector<NodeT>& get_nodes() const {
+        /* Node for each dense id. */
+        return nodes;
+    }
+
+    int node_id(const NodeT& node) const {
+        /* Dense id of node, or -1 if it never appeared in an edge. */
+        auto it = ids.find(node);
+        return it == ids.end() ? -1 : it->second;
     }
 
     std::vector<std::vector<NodeT>> find_sccs() {
-        std::set<NodeT> visited;
-        std::vector<NodeT> finish_order;
+        /* Components as node lists, in topological order of the condensation. */
+        compute_components();
+        std::vector<std::vector<NodeT>> sccs(components);
+        for (int v = 0; v < (int)nodes.size(); v++) { sccs[comp[v]].push_back(nodes[v]); }
+        return sccs;
+    }
+};
+
+template <typename NodeT>
+class IncrementalSCC {
+    /*
+    SCCs under edge insertions. Components are kept in a topological order (Pearce-Kelly). An
+    edge u -> v against the order triggers two bounded searches, forward from v and backward
+    from u, restricted to the components between them. If the forward search reaches u, the
+    components found by both searches form a new cycle and are merged (union-find).
+    Otherwise only the visited components are reordered.
+    */
+  private:
+    std::map<NodeT, int> ids;
+    std::vector<NodeT> nodes;
+    std::vector<int> parent;                // Union-find over node ids; roots are components
+    std::vector<std::vector<int>> out, in;  // Edge endpoints (node ids) per root
+    std::vector<int> ord;                   // Topological position per root
+    std::vector<int> slot;                  // slot[position] = root, or -1 after a merge
+    std::vector<int> mark;                  // Search stamps per root
+    int stamp = 0;
+    std::vector<int> comp_ids;
 
-        for (const auto& [node, _] : graph) {
-            if (visited.find(node) == visited.end()) { dfs1(node, visited, finish_order); }
+    int id_of(const NodeT& node) {
+        auto [it, inserted] = ids.try_emplace(node, nodes.size());
+        if (inserted) {
+            int v = nodes.size();
+            nodes.push_back(node);
+            parent.push_back(v);
+            out.emplace_back();
+            in.emplace_back();
+            ord.push_back(slot.size());
+            slot.push_back(v);
+            mark.push_back(0);
         }
+        return it->second;
+    }
 
-        visited.clear();
-        std::vector<std::vector<NodeT>> sccs;
+    int find(int v) {
+        while (parent[v] != v) { v = parent[v] = parent[parent[v]]; }
+        return v;
+    }
 
-        for (auto it = finish_order.rbegin(); it != finish_order.rend(); ++it) {
-            if (visited.find(*it) == visited.end()) {
-                std::vector<NodeT> scc;
-                dfs2(*it, visited, scc);
-                sccs.push_back(scc);
+    std::vector<int> search(int start, int bound, bool forward, int tag) {
+        /* Roots reachable from start (or reaching it), with ord <= bound (>= bound backward). */
+        std::vector<int> found = {start}, todo = {start};
+        mark[start] = tag;
+        while (!todo.empty()) {
+            int c = todo.back();
+            todo.pop_back();
+            for (int w : forward ? out[c] : in[c]) {
+                int r = find(w);
+                bool inside = forward ? ord[r] <= bound : ord[r] >= bound;
+                if (mark[r] < tag && inside) {
+                    mark[r] = tag;
+                    found.push_back(r);
+                    todo.push_back(r);
+                }
             }
         }
+        return found;
+    }
+
+  public:
+    bool add_edge(NodeT u, NodeT v) {
+        /* Insert u -> v. Returns true if the edge closed a cycle and merged components. */
+        int a = id_of(u);
+        int b = id_of(v);
+        int cu = find(a), cv = find(b);
+        out[cu].push_back(b);
+        in[cv].push_back(a);
+        if (cu == cv || ord[cu] < ord[cv]) { return false; }
+
+        std::vector<int> fwd = search(cv, ord[cu], true, ++stamp);
+        bool cycle = mark[cu] == stamp;
+        std::vector<int> bwd = search(cu, ord[cv], false, ++stamp);
 
+        // Backward-only roots keep the lowest affected positions and forward-only roots the
+        // highest, each in their old relative order; a merged cycle fits anywhere in between
+        auto by_ord = [&](int x, int y) { return ord[x] < ord[y]; };
+        std::sort(fwd.begin(), fwd.end(), by_ord);
+        std::sort(bwd.begin(), bwd.end(), by_ord);
+        std::vector<int> positions, low, high, merged;
+        for (int c : fwd) { positions.push_back(ord[c]); }
+        for (int c : bwd) {
+            if (std::binary_search(fwd.begin(), fwd.end(), c, by_ord)) {
+                merged.push_back(c);
+            } else {
+                positions.push_back(ord[c]);
+                low.push_back(c);
+            }
+        }
+        for (int c : fwd) {
+            if (!std::binary_search(merged.begin(), merged.end(), c, by_ord)) { high.push_back(c); }
+        }
+        std::sort(positions.begin(), positions.end());
+
+        if (cycle) {
+            // Union into the root with the most edges
+            int root = merged[0];
+            for (int c : merged) {
+                if (out[c].size() + in[c].size() > out[root].size() + in[root].size()) { root = c; }
+            }
+            for (int c : merged) {
+                if (c == root) { continue; }
+                parent[c] = root;
+                out[root].insert(out[root].end(), out[c].begin(), out[c].end());
+                in[root].insert(in[root].end(), in[c].begin(), in[c].end());
+                std::vector<int>().swap(out[c]);
+                std::vector<int>().swap(in[c]);
+            }
+            low.push_back(root);
+        }
+
+        for (int p : positions) { slot[p] = -1; }
+        int k = positions.size();
+        for (int i = 0; i < (int)low.size(); i++) {
+            ord[low[i]] = positions[i];
+            slot[positions[i]] = low[i];
+        }
+        for (int i = 0; i < (int)high.size(); i++) {
+            int p = positions[k - high.size() + i];
+            ord[high[i]] = p;
+            slot[p] = high[i];
+        }
+        return cycle;
+    }
+
+    bool same_component(const NodeT& u, const NodeT& v) {
+        auto a = ids.find(u), b = ids.find(v);
+        if (a == ids.end() || b == ids.end()) { return u == v; }
+        return find(a->second) == find(b->second);
+    }
+
+    int compute_components() {
+        /* Dense component ids in topological order, in O(V). */
+        comp_ids.assign(nodes.size(), -1);
+        std::vector<int> rank(nodes.size(), -1);
+        int components = 0;
+        for (int r : slot) {
+            if (r != -1) { rank[r] = components++; }
+        }
+        for (int v = 0; v < (int)nodes.size(); v++) { comp_ids[v] = rank[find(v)]; }
+        return components;
+    }
+
+    const std::vector<int>& component_ids() const {
+        return comp_ids;
+    }
+
+    const std::vector<NodeT>& get_nodes() const {
+        return nodes;
+    }
+
+    std::vector<std::vector<NodeT>> find_sccs() {
+        std::vector<std::vector<NodeT>> sccs(compute_components());
+        for (int v = 0; v < (int)nodes.size(); v++) { sccs[comp_ids[v]].push_back(nodes[v]); }
         return sccs;
     }
 };
 
+template <typename NodeT>
+class ReachabilityIndex {
+    /*
+    Reachability queries on a static graph. SCCs are condensed with KosarajuSCC, then component
+    c gets a bitset row of the components it reaches: its own bit OR the rows of its successors.
+    Successors have larger ids (topological order), so rows are filled from the last component
+    down, and a successor d only contributes words from d / 64 onwards.
+
+    The full closure takes C * C / 8 bytes. If that exceeds the memory budget given to build(),
+    reachable() falls back to a search of the condensation pruned to components <= target, and
+    reachable_batch() computes the closure in column blocks that fit the budget.
+    */
+  private:
+    KosarajuSCC<NodeT> scc;
+    std::vector<uint64_t> closure;  // Row c is closure[c * words..], bit d set iff c reaches d
+    int words = 0;                  // Words per row, 0 if the closure is not materialized
+    size_t budget = 0;
+    std::vector<int> stamp;  // Visit marks of the fallback search
+    int tag = 0;
+    bool built = false;  // Cleared by add_edge(): new nodes have no component yet
+
+    void close_block(int lo, int width, std::vector<uint64_t>& rows) const {
+        /*
+        Reachability restricted to target components [lo, lo + 64 * width). Only components
+        below the block end can reach it, so rows exist for those alone.
+        */
+        const Condensation& dag = scc.get_condensation();
+        int hi = std::min<long long>(dag.sizes.size(), lo + 64LL * width);
+        rows.assign((size_t)hi * width, 0);
+        for (int c = hi - 1; c >= 0; c--) {
+            uint64_t* row = &rows[(size_t)c * width];
+            if (c >= lo) { row[(c - lo) >> 6] |= 1ULL << ((c - lo) & 63); }
+            for (int e = dag.offsets[c]; e < dag.offsets[c + 1]; e++) {
+                int d = dag.targets[e];
+                if (d >= hi) { continue; }
+                const uint64_t* child = &rows[(size_t)d * width];
+                for (int k = std::max(0, (d - lo) >> 6); k < width; k++) { row[k] |= child[k]; }
+            }
+        }
+    }
+
+    bool search(int c, int d) {
+        if (++tag == INT_MAX) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            tag = 1;
+        }
+        const Condensation& dag = scc.get_condensation();
+        std::vector<int> todo = {c};
+        stamp[c] = tag;
+        while (!todo.empty()) {
+            int x = todo.back();
+            todo.pop_back();
+            for (int e = dag.offsets[x]; e < dag.offsets[x + 1]; e++) {
+                int y = dag.targets[e];
+                if (y == d) { return true; }
+                if (y < d && stamp[y] != tag) {
+                    stamp[y] = tag;
+                    todo.push_back(y);
+                }
+            }
+        }
+        return false;
+    }
+
+    void check_built() const {
+        if (!built) { throw std::logic_error("build() not called since the last add_edge()"); }
+    }
+
+    int component_of(const NodeT& node) const {
+        check_built();
+        int id = scc.node_id(node);
+        return id == -1 ? -1 : scc.component_ids()[id];
+    }
+
+  public:
+    void add_edge(NodeT u, NodeT v) {
+        scc.add_edge(u, v);
+        built = false;
+    }
+
+    int build(size_t max_bytes = 1 << 30) {
+        /*
+        Condense the graph and materialize the closure if it fits in max_bytes. Returns the
+        number of components. Call again after adding edges; queries throw logic_error until
+        then.
+        */
+        int c = scc.compute_components(true);
+        budget = max_bytes;
+        words = 0;
+        closure.clear();
+        if ((size_t)c * ((c + 63) / 64) * sizeof(uint64_t) <= max_bytes) {
+            words = (c + 63) / 64;
+            close_block(0, words, closure);
+        }
+        stamp.assign(c, 0);
+        built = true;
+        return c;
+    }
+
+    bool component_reaches(int c, int d) {
+        /* Whether component c reaches component d (ids as in component_ids()). */
+        check_built();
+        if (c > d) { return false; }
+        if (c == d) { return true; }
+        if (words > 0) { return closure[(size_t)c * words + (d >> 6)] >> (d & 63) & 1; }
+        return search(c, d);
+    }
+
+    bool reachable(const NodeT& u, const NodeT& v) {
+        /* Whether there is a path from u to v; nodes that never appeared in an edge reach none. */
+        int c = component_of(u), d = component_of(v);
+        return c != -1 && d != -1 && component_reaches(c, d);
+    }
+
+    std::vector<bool> reachable_batch(const std::vector<std::pair<NodeT, NodeT>>& queries) {
+        /*
+        Answer many queries at once. Without a materialized closure, the target components are
+        split into column blocks of at most budget bytes, and each block answers its queries.
+        */
+        int q = queries.size();
+        std::vector<bool> answer(q, false);
+        std::vector<std::pair<int, int>> comps(q);
+        for (int i = 0; i < q; i++) {
+            comps[i] = {component_of(queries[i].first), component_of(queries[i].second)};
+        }
+        if (words > 0) {
+            for (int i = 0; i < q; i++) {
+                auto [c, d] = comps[i];
+                answer[i] = c != -1 && d != -1 && component_reaches(c, d);
+            }
+            return answer;
+        }
+
+        int components = scc.get_condensation().sizes.size();
+        int width = std::max<size_t>(1, budget / (sizeof(uint64_t) * std::max(components, 1)));
+        std::vector<int> order;
+        for (int i = 0; i < q; i++) {
+            auto [c, d] = comps[i];
+            if (c == -1 || d == -1 || c > d) { continue; }
+            if (c == d) {
+                answer[i] = true;
+            } else {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](int a, int b) { return comps[a].second < comps[b].second; });
+        std::vector<uint64_t> rows;
+        for (int i = 0; i < (int)order.size();) {
+            int lo = comps[order[i]].second;
+            close_block(lo, width, rows);
+            for (; i < (int)order.size() && comps[order[i]].second < lo + 64LL * width; i++) {
+                auto [c, d] = comps[order[i]];
+                answer[order[i]] = rows[(size_t)c * width + ((d - lo) >> 6)] >> ((d - lo) & 63) & 1;
+            }
+        }
+        return answer;
+    }
+
+    const std::vector<int>& component_ids() const {
+        /* Component per dense node id, in topological order. */
+        return scc.component_ids();
+    }
+};
+
 void test_main() {
     KosarajuSCC<int> g;
     g.add_edge(0, 1);
@@ -168,7 +858,332 @@ void test_large_graph() {
     assert(sccs.size() == 10);
 }
 
-int main() {
+void test_deep_chain() {
+    // A recursive DFS would overflow the stack here
+    KosarajuSCC<int> g;
+    int n = 1000000;
+    for (int i = 0; i + 1 < n; i++) { g.add_edge(i, i + 1); }
+    g.add_edge(n - 1, 0);
+    assert(g.find_sccs().size() == 1);
+
+    KosarajuSCC<int> chain;
+    for (int i = 0; i + 1 < n; i++) { chain.add_edge(i, i + 1); }
+    assert(chain.compute_components() == n);
+    for (int i = 0; i < n; i++) { assert(chain.component_ids()[i] == i); }  // Topological order
+}
+
+void test_component_ids() {
+    KosarajuSCC<char> g;
+    g.add_edge('a', 'b');
+    g.add_edge('b', 'a');
+    g.add_edge('b', 'c');
+    g.add_edge('d', 'c');
+    assert(g.compute_components() == 3);
+    const auto& comp = g.component_ids();
+    const auto& nodes = g.get_nodes();
+    assert(nodes == std::vector<char>({'a', 'b', 'c', 'd'}));
+    assert(comp[0] == comp[1]);
+    assert(comp[0] < comp[2] && comp[3] < comp[2]);  // Edges go forward in topological order
+}
+
+void test_topological_order_of_sccs() {
+    KosarajuSCC<int> g;
+    g.add_edge(3, 4);
+    g.add_edge(4, 3);
+    g.add_edge(2, 3);
+    g.add_edge(0, 1);
+    g.add_edge(1, 0);
+    g.add_edge(1, 2);
+    auto sccs = g.find_sccs();
+    for (auto& scc : sccs) { std::sort(scc.begin(), scc.end()); }
+    assert(sccs == std::vector<std::vector<int>>({{0, 1}, {2}, {3, 4}}));
+}
+
+void test_condensation() {
+    KosarajuSCC<int> g;
+    g.add_edge(0, 1);
+    g.add_edge(1, 0);
+    g.add_edge(0, 2);
+    g.add_edge(1, 2);  // Duplicate inter-component edge {0, 1} -> {2}
+    g.add_edge(2, 3);
+    g.add_edge(3, 2);
+    g.add_edge(1, 4);
+    g.add_edge(4, 4);
+    assert(g.compute_components(true) == 3);
+
+    const auto& comp = g.component_ids();
+    const auto& dag = g.get_condensation();
+    int a = comp[0], b = comp[2], c = comp[4];  // Dense ids follow first appearance
+    assert(a == 0);
+    assert(dag.sizes[a] == 2 && dag.sizes[b] == 2 && dag.sizes[c] == 1);
+    std::vector<int> out(dag.targets.begin() + dag.offsets[a],
+                         dag.targets.begin() + dag.offsets[a + 1]);
+    std::sort(out.begin(), out.end());
+    assert(out == std::vector<int>({std::min(b, c), std::max(b, c)}));
+    assert(dag.offsets[b + 1] == dag.offsets[b]);
+    assert(dag.offsets[c + 1] == dag.offsets[c]);
+    assert((int)dag.targets.size() == 2);
+}
+
+void test_condensation_random() {
+    for (int seed = 0; seed < 20; seed++) {
+        KosarajuSCC<int> g;
+        std::vector<std::pair<int, int>> edges;
+        unsigned x = seed * 7919 + 1;
+        for (int i = 0; i < 200; i++) {
+            x = x * 1103515245 + 12345;
+            int u = (x >> 8) % 60;
+            x = x * 1103515245 + 12345;
+            int v = (x >> 8) % 60;
+            g.add_edge(u, v);
+            edges.push_back({u, v});
+        }
+        int components = g.compute_components(true);
+        const auto& comp = g.component_ids();
+        const auto& dag = g.get_condensation();
+        const auto& nodes = g.get_nodes();
+        std::map<int, int> id;
+        for (int i = 0; i < (int)nodes.size(); i++) { id[nodes[i]] = i; }
+
+        std::vector<std::pair<int, int>> expected, actual;
+        for (const auto& [u, v] : edges) {
+            int cu = comp[id[u]], cv = comp[id[v]];
+            assert(cu <= cv);
+            if (cu != cv) { expected.push_back({cu, cv}); }
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        for (int c = 0; c < components; c++) {
+            for (int e = dag.offsets[c]; e < dag.offsets[c + 1]; e++) {
+                actual.push_back({c, dag.targets[e]});
+            }
+        }
+        std::sort(actual.begin(), actual.end());
+        assert(actual == expected);
+
+        int total = 0;
+        for (int size : dag.sizes) { total += size; }
+        assert(total == (int)nodes.size());
+    }
+}
+
+template <typename G>
+int g_id(const G& g, int node) {
+    const auto& nodes = g.get_nodes();
+    return std::find(nodes.begin(), nodes.end(), node) - nodes.begin();
+}
+
+std::vector<std::pair<int, int>> random_graph(int n, int m, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i < m; i++) { edges.push_back({(int)(rng() % n), (int)(rng() % n)}); }
+    return edges;
+}
+
+bool same_partition(const std::vector<int>& a, const std::vector<int>& b) {
+    std::map<int, int> a_to_b, b_to_a;
+    for (int v = 0; v < (int)a.size(); v++) {
+        if (a_to_b.try_emplace(a[v], b[v]).first->second != b[v]) { return false; }
+        if (b_to_a.try_emplace(b[v], a[v]).first->second != a[v]) { return false; }
+    }
+    return true;
+}
+
+void test_parallel_matches_sequential() {
+    for (int seed = 0; seed < 30; seed++) {
+        int n = 50 + seed * 40, m = n * (1 + seed % 4);
+        KosarajuSCC<int> g;
+        for (const auto& [u, v] : random_graph(n, m, seed)) { g.add_edge(u, v); }
+        int components = g.compute_components();
+        std::vector<int> sequential = g.component_ids();
+        for (int threads : {1, 2, 4}) {
+            assert(g.compute_components_parallel(threads) == components);
+            assert(same_partition(g.component_ids(), sequential));
+        }
+    }
+
+    // Long cycle plus tail: exercises deep BFS and long trim chains
+    KosarajuSCC<int> g;
+    for (int i = 0; i < 20000; i++) { g.add_edge(i, (i + 1) % 20000); }
+    for (int i = 20000; i < 40000; i++) { g.add_edge(i, i + 1); }
+    assert(g.compute_components_parallel(4) == 1 + 20001);
+
+    // Chain of 2-cycles (2i <-> 2i+1, 2i -> 2i+2), numbered both ways: plain forward-backward
+    // peels one SCC per round here, which took minutes for this size (timed in benchmark())
+    const int k = 40000;
+    for (bool reversed : {false, true}) {
+        KosarajuSCC<int> chain;
+        auto id = [&](int v) { return reversed ? 2 * k - 1 - v : v; };
+        for (int i = 0; i < k; i++) {
+            chain.add_edge(id(2 * i), id(2 * i + 1));
+            chain.add_edge(id(2 * i + 1), id(2 * i));
+            if (i + 1 < k) { chain.add_edge(id(2 * i), id(2 * i + 2)); }
+        }
+        chain.compute_components();
+        std::vector<int> sequential = chain.component_ids();
+        for (int threads : {1, 4}) {
+            assert(chain.compute_components_parallel(threads) == k);
+            assert(same_partition(chain.component_ids(), sequential));
+        }
+    }
+}
+
+void test_incremental_scc() {
+    IncrementalSCC<int> g;
+    assert(!g.add_edge(0, 1));
+    assert(!g.add_edge(1, 2));
+    assert(!g.same_component(0, 2));
+    assert(g.add_edge(2, 0));  // Closes 0 -> 1 -> 2 -> 0
+    assert(g.same_component(0, 2));
+    assert(!g.add_edge(2, 3));
+    assert(!g.add_edge(1, 0));  // Already in one component
+    assert(g.compute_components() == 2);
+    auto sccs = g.find_sccs();
+    std::sort(sccs[0].begin(), sccs[0].end());
+    assert(sccs[0] == std::vector<int>({0, 1, 2}) && sccs[1] == std::vector<int>({3}));
+}
+
+void test_incremental_matches_batch() {
+    for (int seed = 0; seed < 20; seed++) {
+        int n = 10 + seed * 3;
+        auto edges = random_graph(n, 3 * n, seed + 100);
+        IncrementalSCC<int> incremental;
+        KosarajuSCC<int> batch;
+        int previous = 0;
+        for (int i = 0; i < (int)edges.size(); i++) {
+            auto [u, v] = edges[i];
+            int nodes_before = incremental.get_nodes().size();
+            bool cycle = incremental.add_edge(u, v);
+            batch.add_edge(u, v);
+            int new_nodes = incremental.get_nodes().size() - nodes_before;
+
+            int components = batch.compute_components();
+            assert(incremental.compute_components() == components);
+            assert(cycle == (components < previous + new_nodes));
+            assert(incremental.get_nodes() == batch.get_nodes());
+            assert(same_partition(incremental.component_ids(), batch.component_ids()));
+            const auto& comp = incremental.component_ids();
+            for (int j = 0; j <= i; j++) {  // Ids are in topological order
+                assert(comp[g_id(incremental, edges[j].first)] <=
+                       comp[g_id(incremental, edges[j].second)]);
+            }
+            previous = components;
+        }
+    }
+}
+
+void test_reachability_index() {
+    ReachabilityIndex<int> index;
+    index.add_edge(0, 1);
+    index.add_edge(1, 2);
+    index.add_edge(2, 1);
+    index.add_edge(2, 3);
+    index.add_edge(4, 3);
+    assert(index.build() == 4);
+    assert(index.reachable(0, 3) && index.reachable(2, 1) && index.reachable(4, 4));
+    assert(!index.reachable(3, 0) && !index.reachable(0, 4) && !index.reachable(1, 0));
+    assert(!index.reachable(0, 99));
+
+    ReachabilityIndex<int> fresh;
+    fresh.add_edge(0, 1);
+    bool caught = false;
+    try {
+        fresh.reachable(0, 1);
+    } catch (const std::logic_error&) { caught = true; }
+    assert(caught);
+    fresh.build();
+    assert(fresh.reachable(0, 1));
+    fresh.add_edge(1, 2);  // Node 2 has no component until the next build()
+    caught = false;
+    try {
+        fresh.reachable_batch({{0, 2}});
+    } catch (const std::logic_error&) { caught = true; }
+    assert(caught);
+    fresh.build();
+    assert(fresh.reachable(0, 2));
+}
+
+void test_reachability_matches_bfs() {
+    for (int seed = 0; seed < 10; seed++) {
+        int n = 100 + seed * 30;
+        auto edges = random_graph(n, n + seed * 20, seed + 200);
+        std::vector<std::vector<int>> adj(n);
+        std::vector<bool> present(n, false);
+        ReachabilityIndex<int> full, small;
+        for (const auto& [u, v] : edges) {
+            adj[u].push_back(v);
+            present[u] = present[v] = true;
+            full.add_edge(u, v);
+            small.add_edge(u, v);
+        }
+        full.build();
+        small.build(64);  // Forces the fallback search and the blocked batch mode
+
+        std::vector<std::pair<int, int>> queries;
+        std::vector<bool> expected;
+        for (int s = 0; s < n; s++) {
+            std::vector<bool> seen(n, false);
+            std::vector<int> todo = {s};
+            seen[s] = true;
+            while (!todo.empty()) {
+                int x = todo.back();
+                todo.pop_back();
+                for (int y : adj[x]) {
+                    if (!seen[y]) {
+                        seen[y] = true;
+                        todo.push_back(y);
+                    }
+                }
+            }
+            for (int t = 0; t < n; t++) {
+                queries.push_back({s, t});
+                expected.push_back(present[s] && present[t] && seen[t]);  // Isolated: false
+            }
+        }
+        for (int i = 0; i < (int)queries.size(); i++) {
+            assert(full.reachable(queries[i].first, queries[i].second) == expected[i]);
+            assert(small.reachable(queries[i].first, queries[i].second) == expected[i]);
+        }
+        assert(full.reachable_batch(queries) == expected);
+        assert(small.reachable_batch(queries) == expected);
+    }
+}
+
+void benchmark(int n, int m) {
+    // Run with: ./kosaraju_scc bench [nodes] [edges]
+    auto edges = random_graph(n, m, 1);
+    KosarajuSCC<int> g;
+    for (const auto& [u, v] : edges) { g.add_edge(u, v); }
+    auto time_ms = [](auto&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    };
+    std::cout << "sequential ms\t" << time_ms([&] { g.compute_components(); }) << std::endl;
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::cout << threads << " threads ms\t"
+                  << time_ms([&] { g.compute_components_parallel(threads); }) << std::endl;
+    }
+    // Chain of 2-cycles: one SCC per forward-backward round without the sequential fallback
+    KosarajuSCC<int> chain;
+    for (int i = 0; i < n / 2; i++) {
+        chain.add_edge(2 * i, 2 * i + 1);
+        chain.add_edge(2 * i + 1, 2 * i);
+        if (2 * i + 2 < n) { chain.add_edge(2 * i, 2 * i + 2); }
+    }
+    std::cout << "2-cycle chain sequential ms\t" << time_ms([&] { chain.compute_components(); })
+              << std::endl;
+    std::cout << "2-cycle chain " << max_threads << " threads ms\t"
+              << time_ms([&] { chain.compute_components_parallel(max_threads); }) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark(argc > 2 ? std::stoi(argv[2]) : 1000000, argc > 3 ? std::stoi(argv[3]) : 5000000);
+        return 0;
+    }
     test_main();
     test_single_node();
     test_no_edges();
@@ -177,6 +1192,16 @@ int main() {
     test_multiple_components();
     test_complex_graph();
     test_large_graph();
+    test_deep_chain();
+    test_component_ids();
+    test_topological_order_of_sccs();
+    test_condensation();
+    test_condensation_random();
+    test_parallel_matches_sequential();
+    test_incremental_scc();
+    test_incremental_matches_batch();
+    test_reachability_index();
+    test_reachability_matches_bfs();
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }
@@ -0,0 +1,202 @@
+/*
+Rabin-Karp multi-pattern search with a 64-bit polynomial rolling hash modulo 2^61 - 1.
+
+Patterns are grouped by length. Each group hashes its patterns into an open-addressing
+table, and the text is scanned once per distinct pattern length. Every hash hit is verified
+by a direct comparison, so reported matches are always exact.
+
+Time complexity: O(P + L * n + occ) expected, where P is total pattern length, L is the
+number of distinct pattern lengths, n is text length and occ is the number of matches.
+Space complexity: O(P) for the patterns and hash tables.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MultiPatternRabinKarp {
+  private:
+    static constexpr uint64_t MOD = (1ULL << 61) - 1;
+
+    struct Group {
+        int length;
+        uint64_t power;              // base^(length - 1) mod MOD
+        std::vector<uint64_t> keys;  // hash per slot
+        std::vector<int> ids;        // pattern index per slot, -1 if empty
+    };
+
+    std::vector<std::string> patterns;
+    std::vector<Group> groups;
+    uint64_t base;
+
+    static uint64_t mul(uint64_t a, uint64_t b) {
+        __uint128_t p = (__uint128_t)a * b;
+        uint64_t r = (uint64_t)(p >> 61) + (uint64_t)(p & MOD);
+        return r >= MOD ? r - MOD : r;
+    }
+
+    static uint64_t add(uint64_t a, uint64_t b) {
+        uint64_t r = a + b;
+        return r >= MOD ? r - MOD : r;
+    }
+
+    uint64_t hash(const char* s, int len) const {
+        uint64_t h = 0;
+        for (int i = 0; i < len; i++) { h = add(mul(h, base), (unsigned char)s[i] + 1); }
+        return h;
+    }
+
+    static size_t slot(uint64_t h, size_t mask) {
+        return (h ^ (h >> 29)) & mask;
+    }
+
+  public:
+    MultiPatternRabinKarp(const std::vector<std::string>& patterns) : patterns(patterns) {
+        std::mt19937_64 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+        base = rng() % (MOD - 1000) + 500;  // Random base defeats adversarial inputs
+
+        std::map<int, std::vector<int>> by_length;
+        for (int i = 0; i < (int)patterns.size(); i++) {
+            if (!patterns[i].empty()) { by_length[patterns[i].length()].push_back(i); }
+        }
+
+        for (const auto& [len, members] : by_length) {
+            Group g{len, 1, {}, {}};
+            for (int i = 1; i < len; i++) { g.power = mul(g.power, base); }
+
+            size_t capacity = 1;
+            while (capacity < 2 * members.size()) { capacity *= 2; }  // load factor <= 1/2
+            g.keys.assign(capacity, 0);
+            g.ids.assign(capacity, -1);
+
+            for (int id : members) {
+                uint64_t h = hash(patterns[id].data(), len);
+                size_t s = slot(h, capacity - 1);
+                while (g.ids[s] != -1) { s = (s + 1) & (capacity - 1); }
+                g.keys[s] = h;
+                g.ids[s] = id;
+            }
+            groups.push_back(std::move(g));
+        }
+    }
+
+    std::vector<std::pair<int, int>> search(const std::string& text) const {
+        /*
+        Find all occurrences of all patterns in text.
+
+        Returns (position, pattern index) pairs sorted by position, then pattern index.
+        */
+        std::vector<std::pair<int, int>> matches;
+        int n = text.length();
+
+        for (const auto& g : groups) {
+            if (g.length > n) { continue; }
+            size_t mask = g.ids.size() - 1;
+            uint64_t h = hash(text.data(), g.length);
+
+            for (int i = 0;; i++) {
+                for (size_t s = slot(h, mask); g.ids[s] != -1; s = (s + 1) & mask) {
+                    if (g.keys[s] == h &&
+                        std::memcmp(text.data() + i, patterns[g.ids[s]].data(), g.length) == 0) {
+                        matches.push_back({i, g.ids[s]});
+                    }
+                }
+                if (i + g.length >= n) { break; }
+                // Roll: drop text[i], append text[i + length]
+                uint64_t out = mul((unsigned char)text[i] + 1, g.power);
+                h = add(mul(add(h, MOD - out), base), (unsigned char)text[i + g.length] + 1);
+            }
+        }
+
+        std::sort(matches.begin(), matches.end());
+        return matches;
+    }
+};
+
+void test_main() {
+    MultiPatternRabinKarp rk({"aba", "bab", "abc", "ab"});
+    auto matches = rk.search("ababcab");
+    std::vector<std::pair<int, int>> expected = {{0, 0}, {0, 3}, {1, 1}, {2, 2}, {2, 3}, {5, 3}};
+    assert(matches == expected);
+}
+
+// Don't write tests below during competition.
+
+void test_empty_inputs() {
+    MultiPatternRabinKarp none({});
+    assert(none.search("abc").empty());
+
+    MultiPatternRabinKarp empty_pattern({"", "a"});
+    std::vector<std::pair<int, int>> expected = {{0, 1}, {1, 1}};
+    assert(empty_pattern.search("aa") == expected);
+
+    MultiPatternRabinKarp rk({"abc"});
+    assert(rk.search("").empty());
+    assert(rk.search("ab").empty());
+}
+
+void test_full_text_match() {
+    MultiPatternRabinKarp rk({"hello"});
+    std::vector<std::pair<int, int>> expected = {{0, 0}};
+    assert(rk.search("hello") == expected);
+}
+
+void test_duplicate_patterns() {
+    MultiPatternRabinKarp rk({"aa", "aa"});
+    auto matches = rk.search("aaa");
+    std::vector<std::pair<int, int>> expected = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+    assert(matches == expected);
+}
+
+void test_binary_bytes() {
+    std::string text("\x00\xff\x00\xff", 4);
+    MultiPatternRabinKarp rk({std::string("\xff\x00", 2), std::string("\x00", 1)});
+    auto matches = rk.search(text);
+    std::vector<std::pair<int, int>> expected = {{0, 1}, {1, 0}, {2, 1}};
+    assert(matches == expected);
+}
+
+void test_many_patterns_against_brute_force() {
+    std::mt19937 rng(12345);
+    std::string text(5000, 'a');
+    for (auto& c : text) { c = 'a' + rng() % 3; }
+
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 2000; i++) {
+        int len = 1 + rng() % 8;
+        std::string p(len, 'a');
+        for (auto& c : p) { c = 'a' + rng() % 3; }
+        patterns.push_back(p);
+    }
+
+    std::vector<std::pair<int, int>> expected;
+    for (int i = 0; i < (int)text.size(); i++) {
+        for (int j = 0; j < (int)patterns.size(); j++) {
+            if (text.compare(i, patterns[j].size(), patterns[j]) == 0) {
+                expected.push_back({i, j});
+            }
+        }
+    }
+
+    MultiPatternRabinKarp rk(patterns);
+    assert(rk.search(text) == expected);
+}
+
+int main() {
+    test_main();
+    test_empty_inputs();
+    test_full_text_match();
+    test_duplicate_patterns();
+    test_binary_bytes();
+    test_many_patterns_against_brute_force();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -1,33 +1,389 @@
 /*
 Suffix Array construction with Longest Common Prefix (LCP) array using Kasai's algorithm.
 
-Time complexity: O(n log n) for suffix array, O(n) for LCP array.
-Space complexity: O(n).
+The suffix array is built with SA-IS (induced sorting) in linear time. Prefix doubling with
+radix sort is kept as a simpler O(n log n) alternative that is easier to type. Passing
+threads > 1 builds both arrays in parallel (radix-sorted doubling and PLCP-form Kasai).
+Indices are int, so texts must be shorter than INT_MAX (2^31 - 1) characters; every builder
+throws length_error on longer input before allocating.
+
+Pattern search compares each suffix from min(l, r), the shorter LCP of the pattern with the
+interval ends, so no suffix is ever copied. The optional build_search_index() adds the
+Manber-Myers LLCP/RLCP arrays, so no character is compared twice.
+
+GeneralizedSuffixArray indexes many documents at once and reports matches as (document,
+offset). list_documents reports each matching document once (Muthukrishnan's algorithm).
+
+SuffixArray::save writes a versioned binary file that SuffixArrayView memory-maps read-only,
+so worker processes can search a prebuilt index without deserializing it. Entries are stored in
+the writer's byte order, recorded in the header, and a view rejects a file of the other order.
+Opening a view checks the text length and a sampled hash; hashing the full text is opt-in.
+
+FMIndex is a compressed alternative (BWT in a wavelet matrix plus a sampled suffix array)
+answering count in O(m) and locate in O(m + occ * sample_rate) without storing the text.
+
+Time complexity: O(n) for suffix array (SA-IS), O(n) for LCP array, O(m log n) per pattern
+search, O(m + log n) after the optional O(n) build_search_index(), O(1) per lce query after
+the optional O(n log n) build_lce_index().
+Space complexity: O(n), about 5n bytes of working memory during SA-IS construction.
 */
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+int checked_length(size_t length) {
+    /* Text length as an int index; n + 1 (the sentinel or '$' row) must fit too. */
+    if (length >= (size_t)INT_MAX) { throw std::length_error("text too long for int indices"); }
+    return length;
+}
+
+std::vector<int> suffix_array_doubling(const std::string& text) {
+    /*
+    Prefix doubling: after the round with step k, suffixes are sorted by their first 2k
+    characters. Each round orders the (rank[i], rank[i + k]) pairs with two stable
+    counting sorts, so no suffix is ever copied or compared character by character.
+    */
+    int n = checked_length(text.length());
+    if (n == 0) { return {}; }
+
+    std::vector<int> suffixes(n), rank(n), tmp(n), cnt(std::max(256, n), 0);
+    for (int i = 0; i < n; i++) {
+        rank[i] = (unsigned char)text[i];
+        cnt[rank[i]]++;
+    }
+    for (int i = 1; i < (int)cnt.size(); i++) { cnt[i] += cnt[i - 1]; }
+    for (int i = n - 1; i >= 0; i--) { suffixes[--cnt[rank[i]]] = i; }
+
+    for (int k = 1;; k <<= 1) {
+        // Order by second key: suffixes without one first, then the rest in current order
+        int p = 0;
+        for (int i = n - k; i < n; i++) { tmp[p++] = i; }
+        for (int i = 0; i < n; i++) {
+            if (suffixes[i] >= k) { tmp[p++] = suffixes[i] - k; }
+        }
+
+        // Stable counting sort by first key
+        std::fill(cnt.begin(), cnt.end(), 0);
+        for (int i = 0; i < n; i++) { cnt[rank[i]]++; }
+        for (int i = 1; i < (int)cnt.size(); i++) { cnt[i] += cnt[i - 1]; }
+        for (int i = n - 1; i >= 0; i--) { suffixes[--cnt[rank[tmp[i]]]] = tmp[i]; }
+
+        // Re-rank into tmp, then reuse the old rank array as next round's buffer
+        auto second = [&](int i) { return i + k < n ? rank[i + k] : -1; };
+        tmp[suffixes[0]] = 0;
+        for (int i = 1; i < n; i++) {
+            int a = suffixes[i - 1], b = suffixes[i];
+            bool differ = rank[a] != rank[b] || second(a) != second(b);
+            tmp[b] = tmp[a] + (differ ? 1 : 0);
+        }
+        std::swap(rank, tmp);
+
+        if (rank[suffixes[n - 1]] == n - 1) { break; }
+    }
+
+    return suffixes;
+}
+
+struct IntSymbols {
+    const int* s;
+    int operator()(int i) const {
+        return s[i];
+    }
+};
+
+template <typename Chr>
+void sa_is(const Chr& chr, int* sa, int n, int max_symbol) {
+    /*
+    SA-IS (Nong, Zhang, Chan). chr(i) returns symbol i in [0, max_symbol] (inclusive), and
+    chr(n - 1) must be a unique smallest sentinel 0. The reduced problem is stored in the tail
+    of sa, so the working memory beyond sa is n bits of suffix types plus one bucket array per
+    level.
+    */
+    std::vector<bool> type(n);  // true = S-type
+    type[n - 1] = true;
+    for (int i = n - 2; i >= 0; i--) {
+        type[i] = chr(i) < chr(i + 1) || (chr(i) == chr(i + 1) && type[i + 1]);
+    }
+    auto is_lms = [&](int i) { return i > 0 && type[i] && !type[i - 1]; };
+
+    std::vector<int> bucket(max_symbol + 1);
+    auto get_buckets = [&](bool end) {
+        std::fill(bucket.begin(), bucket.end(), 0);
+        for (int i = 0; i < n; i++) { bucket[chr(i)]++; }
+        int sum = 0;
+        for (int c = 0; c <= max_symbol; c++) {
+            sum += bucket[c];
+            bucket[c] = end ? sum : sum - bucket[c];
+        }
+    };
+    auto induce = [&]() {
+        get_buckets(false);
+        for (int i = 0; i < n; i++) {
+            int j = sa[i] - 1;
+            if (j >= 0 && !type[j]) { sa[bucket[chr(j)]++] = j; }
+        }
+        get_buckets(true);
+        for (int i = n - 1; i >= 0; i--) {
+            int j = sa[i] - 1;
+            if (j >= 0 && type[j]) { sa[--bucket[chr(j)]] = j; }
+        }
+    };
+
+    // Stage 1: sort LMS substrings by inducing from their bucket ends
+    get_buckets(true);
+    std::fill(sa, sa + n, -1);
+    for (int i = 1; i < n; i++) {
+        if (is_lms(i)) { sa[--bucket[chr(i)]] = i; }
+    }
+    induce();
+
+    // Name the sorted LMS substrings; names go to sa[n1 + pos / 2], then to the tail
+    int n1 = 0;
+    for (int i = 0; i < n; i++) {
+        if (is_lms(sa[i])) { sa[n1++] = sa[i]; }
+    }
+    std::fill(sa + n1, sa + n, -1);
+    int names = 0, prev = -1;
+    for (int i = 0; i < n1; i++) {
+        int pos = sa[i];
+        bool diff = prev == -1;
+        for (int d = 0; !diff; d++) {
+            if (chr(pos + d) != chr(prev + d) || type[pos + d] != type[prev + d]) {
+                diff = true;
+            } else if (d > 0 && (is_lms(pos + d) || is_lms(prev + d))) {
+                break;
+            }
+        }
+        if (diff) {
+            names++;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = names - 1;
+    }
+    for (int i = n - 1, j = n - 1; i >= n1; i--) {
+        if (sa[i] >= 0) { sa[j--] = sa[i]; }
+    }
+
+    // Stage 2: sort the reduced string recursively unless all names are unique
+    int* s1 = sa + n - n1;
+    if (names < n1) {
+        sa_is(IntSymbols{s1}, sa, n1, names - 1);
+    } else {
+        for (int i = 0; i < n1; i++) { sa[s1[i]] = i; }
+    }
+
+    // Stage 3: place LMS suffixes in sorted order at their bucket ends, then induce
+    for (int i = 1, j = 0; i < n; i++) {
+        if (is_lms(i)) { s1[j++] = i; }
+    }
+    for (int i = 0; i < n1; i++) { sa[i] = s1[sa[i]]; }
+    std::fill(sa + n1, sa + n, -1);
+    get_buckets(true);
+    for (int i = n1 - 1; i >= 0; i--) {
+        int j = sa[i];
+        sa[i] = -1;
+        sa[--bucket[chr(j)]] = j;
+    }
+    induce();
+}
+
+std::vector<int> suffix_array_sais(const std::string& text) {
+    /* Suffix array of a byte string in O(n) time using 4n bytes plus n bits of memory. */
+    int n = checked_length(text.length());
+    if (n == 0) { return {}; }
+    std::vector<int> sa(n + 1);
+    auto chr = [&](int i) { return i == n ? 0 : (unsigned char)text[i] + 1; };
+    sa_is(chr, sa.data(), n + 1, 256);  // Bytes shifted to [1, 256]
+    sa.erase(sa.begin());  // Drop the virtual sentinel suffix
+    return sa;
+}
+
+std::vector<int> suffix_array_sais(const std::vector<int>& s, int alphabet) {
+    /* Suffix array of an integer string with symbols in [0, alphabet) in O(n + alphabet). */
+    int n = checked_length(s.size());
+    if (n == 0) { return {}; }
+    std::vector<int> sa(n + 1);
+    auto chr = [&](int i) { return i == n ? 0 : s[i] + 1; };
+    sa_is(chr, sa.data(), n + 1, alphabet);  // Symbols shifted to [1, alphabet]
+    sa.erase(sa.begin());
+    return sa;
+}
+
+template <typename F>
+void parallel_chunks(int threads, int n, const F& f) {
+    /* Run f(begin, end, t) on threads contiguous chunks of [0, n). */
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        int begin = (long long)n * t / threads, end = (long long)n * (t + 1) / threads;
+        workers.emplace_back([&f, begin, end, t] { f(begin, end, t); });
+    }
+    for (auto& w : workers) { w.join(); }
+}
+
+std::vector<int> suffix_array_parallel(const std::string& text, int threads) {
+    /*
+    Prefix doubling where each round sorts (rank[i], rank[i + k]) packed into 64-bit keys with
+    a parallel LSD radix sort (per-thread digit histograms, stable scatter), then re-ranks with
+    a parallel prefix sum. Returns the same array as the serial builders.
+    */
+    int n = checked_length(text.length());
+    if (n == 0) { return {}; }
+    int bits = 1;  // Ranks (initially bytes) and rank + 1 both fit in bits
+    while ((1LL << bits) <= std::max(n, 256) + 1) { bits++; }
+
+    std::vector<int> rank(n), idx(n), idx_tmp(n);
+    std::vector<uint64_t> key(n), key_tmp(n);
+    std::vector<std::array<int, 256>> count(threads);
+    std::vector<int> chunk_sum(threads);
+    for (int i = 0; i < n; i++) { rank[i] = (unsigned char)text[i]; }
+
+    for (int k = 1;; k <<= 1) {
+        parallel_chunks(threads, n, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                key[i] = (uint64_t)rank[i] << bits | (i + k < n ? rank[i + k] + 1 : 0);
+                idx[i] = i;
+            }
+        });
+
+        for (int shift = 0; shift < 2 * bits; shift += 8) {
+            parallel_chunks(threads, n, [&](int begin, int end, int t) {
+                count[t].fill(0);
+                for (int i = begin; i < end; i++) { count[t][key[i] >> shift & 255]++; }
+            });
+            for (int d = 0, offset = 0; d < 256; d++) {
+                for (int t = 0; t < threads; t++) {
+                    int c = count[t][d];
+                    count[t][d] = offset;
+                    offset += c;
+                }
+            }
+            parallel_chunks(threads, n, [&](int begin, int end, int t) {
+                for (int i = begin; i < end; i++) {
+                    int pos = count[t][key[i] >> shift & 255]++;
+                    key_tmp[pos] = key[i];
+                    idx_tmp[pos] = idx[i];
+                }
+            });
+            key.swap(key_tmp);
+            idx.swap(idx_tmp);
+        }
+
+        // New rank = number of distinct keys before, via a two-pass parallel prefix sum
+        parallel_chunks(threads, n, [&](int begin, int end, int t) {
+            int c = 0;
+            for (int i = std::max(begin, 1); i < end; i++) { c += key[i] != key[i - 1]; }
+            chunk_sum[t] = c;
+        });
+        for (int t = 0, offset = 0; t < threads; t++) {
+            int c = chunk_sum[t];
+            chunk_sum[t] = offset;
+            offset += c;
+        }
+        parallel_chunks(threads, n, [&](int begin, int end, int t) {
+            int r = chunk_sum[t];
+            for (int i = begin; i < end; i++) {
+                if (i > 0 && key[i] != key[i - 1]) { r++; }
+                rank[idx[i]] = r;
+            }
+        });
+
+        if (rank[idx[n - 1]] == n - 1) { break; }
+    }
+    return idx;
+}
+
+std::vector<int> lcp_array_parallel(const std::string& text, const std::vector<int>& sa,
+                                    int threads) {
+    /*
+    Kasai's algorithm in the permuted (PLCP) form: phi[i] is the suffix preceding suffix i in
+    sa, and plcp[i] >= plcp[i - 1] - 1 lets each thread scan its own range of text positions.
+    Only the carried match length is lost at chunk borders.
+    */
+    int n = checked_length(text.length());
+    if (n == 0) { return {}; }
+    std::vector<int> phi(n), plcp(n), lcp(n);
+    parallel_chunks(threads, n, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) { phi[sa[i]] = i > 0 ? sa[i - 1] : -1; }
+    });
+    parallel_chunks(threads, n, [&](int begin, int end, int) {
+        int h = 0;
+        for (int i = begin; i < end; i++) {
+            int j = phi[i];
+            if (j < 0) {
+                h = 0;
+            } else {
+                while (i + h < n && j + h < n && text[i + h] == text[j + h]) { h++; }
+            }
+            plcp[i] = h;
+            if (h > 0) { h--; }
+        }
+    });
+    parallel_chunks(threads, n, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) { lcp[i] = plcp[sa[i]]; }
+    });
+    return lcp;
+}
+
+const uint64_t BYTE_ORDER_MARK = 0x0102030405060708ULL;
+
+struct SuffixArrayFileHeader {
+    char magic[8];              // "SUFARRAY"
+    uint32_t version;           // 2
+    uint32_t width;             // Bytes per SA/LCP entry: 4 or 8
+    uint64_t byte_order;        // BYTE_ORDER_MARK in the writer's byte order
+    uint64_t n;                 // Text length
+    uint64_t text_hash;         // FNV-1a of the text
+    uint64_t text_sample_hash;  // FNV-1a of TEXT_SAMPLES evenly spaced bytes
+};
+
+const size_t TEXT_SAMPLES = 4096;
+
+uint64_t text_hash(std::string_view text, size_t samples = SIZE_MAX) {
+    /* FNV-1a of the text, or of samples evenly spaced bytes if the text is longer. */
+    uint64_t h = 1469598103934665603ULL;
+    size_t n = text.length(), k = std::min(n, samples), step = k == n ? 1 : n / k;
+    for (size_t i = 0; i < k; i++) { h = (h ^ (unsigned char)text[i * step]) * 1099511628211ULL; }
+    return h;
+}
+
 class SuffixArray {
   private:
     std::string text;
     int n;
     std::vector<int> sa;
     std::vector<int> lcp;
+    std::vector<int> llcp, rlcp;           // Binary search tree LCPs, see build_search_tree
+    std::vector<int> rank;                 // rank[i] = position of suffix i in sa
+    std::vector<std::vector<int>> sparse;  // sparse[k][i] = min(lcp[i .. i + 2^k - 1])
 
-    std::vector<int> build_suffix_array() {
-        std::vector<int> suffixes(n);
-        for (int i = 0; i < n; i++) { suffixes[i] = i; }
-        std::sort(suffixes.begin(), suffixes.end(),
-                  [this](int a, int b) { return text.substr(a) < text.substr(b); });
-        return suffixes;
+    std::vector<int> build_suffix_array(int threads) {
+        return threads > 1 ? suffix_array_parallel(text, threads) : suffix_array_sais(text);
     }
 
-    std::vector<int> build_lcp_array() {
+    std::vector<int> build_lcp_array(int threads) {
         if (n == 0) { return {}; }
+        if (threads > 1) { return lcp_array_parallel(text, sa, threads); }
 
         std::vector<int> rank(n);
         for (int i = 0; i < n; i++) { rank[sa[i]] = i; }
@@ -47,58 +403,612 @@ class SuffixArray {
         return lcp;
     }
 
-  public:
-    SuffixArray(const std::string& text) : text(text), n(text.length()) {
-        sa = build_suffix_array();
-        lcp = build_lcp_array();
+    template <typename Word>
+    static void write_entries(std::ofstream& out, const std::vector<int>& values) {
+        /* Widen into a buffer and write it in chunks of 64K entries. */
+        const size_t chunk = 1 << 16;
+        std::vector<Word> buffer;
+        for (size_t i = 0; i < values.size(); i += chunk) {
+            buffer.assign(values.begin() + i, values.begin() + std::min(values.size(), i + chunk));
+            out.write((const char*)buffer.data(), buffer.size() * sizeof(Word));
+        }
     }
 
-    std::vector<int> find_pattern(const std::string& pattern) {
-        if (pattern.empty()) { return {}; }
+    int build_search_tree(int left, int right) {
+        /*
+        Fill llcp[mid] = LCP(sa[left], sa[mid]) and rlcp[mid] = LCP(sa[mid], sa[right]) for every
+        midpoint visited by a binary search over the open interval (left, right). Returns
+        LCP(sa[left], sa[right]), which is 0 when either end is the virtual -1 or n boundary.
+        */
+        if (right - left == 1) { return left < 0 || right >= n ? 0 : lcp[right]; }
+        int mid = (left + right) / 2;
+        llcp[mid] = build_search_tree(left, mid);
+        rlcp[mid] = build_search_tree(mid, right);
+        return left < 0 || right >= n ? 0 : std::min(llcp[mid], rlcp[mid]);
+    }
 
+    int bound(std::string_view pattern, bool upper) const {
+        /*
+        Binary search: first SA index whose suffix is >= pattern (upper = false) or whose first
+        m characters are > pattern (upper = true). l and r are the LCPs of the pattern with the
+        suffixes at the interval ends; with LLCP/RLCP (Manber-Myers) no character is compared
+        twice, without them mid is compared from min(l, r).
+        */
         int m = pattern.length();
-        int left = 0, right = n;
+        int left = -1, right = n, l = 0, r = 0;
 
-        while (left < right) {
+        while (right - left > 1) {
             int mid = (left + right) / 2;
-            if (text.substr(sa[mid]) < pattern) {
+            int h;
+            if (llcp.empty()) {
+                h = std::min(l, r);
+            } else if (l >= r) {
+                if (llcp[mid] > l) {  // mid compares to the pattern like sa[left] does
+                    left = mid;
+                    continue;
+                }
+                if (llcp[mid] < l) {  // mid differs from sa[left] before the pattern does
+                    right = mid;
+                    r = llcp[mid];
+                    continue;
+                }
+                h = l;
+            } else {
+                if (rlcp[mid] > r) {
+                    right = mid;
+                    continue;
+                }
+                if (rlcp[mid] < r) {
+                    left = mid;
+                    l = rlcp[mid];
+                    continue;
+                }
+                h = r;
+            }
+
+            int pos = sa[mid];
+            while (h < m && pos + h < n && text[pos + h] == pattern[h]) { h++; }
+            bool go_right;
+            if (h == m) {
+                go_right = upper;
+            } else {
+                go_right = pos + h == n || (unsigned char)text[pos + h] < (unsigned char)pattern[h];
+            }
+            if (go_right) {
+                left = mid;
+                l = h;
+            } else {
+                right = mid;
+                r = h;
+            }
+        }
+
+        return right;
+    }
+
+  public:
+    SuffixArray(const std::string& text, int threads = 1)
+        : text(text), n(checked_length(text.length())) {
+        sa = build_suffix_array(threads);
+        lcp = build_lcp_array(threads);
+    }
+
+    std::pair<int, int> find_range(std::string_view pattern) const {
+        /* Half-open range [start, end) of SA indices whose suffixes start with pattern. */
+        if (pattern.empty()) { return {0, 0}; }
+        return {bound(pattern, false), bound(pattern, true)};
+    }
+
+    int count_pattern(std::string_view pattern) const {
+        auto [start, end] = find_range(pattern);
+        return end - start;
+    }
+
+    std::vector<int> find_pattern(std::string_view pattern) const {
+        auto [start, end] = find_range(pattern);
+        std::vector<int> result(sa.begin() + start, sa.begin() + end);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void build_search_index() {
+        /* Optional LLCP/RLCP arrays (2n ints) making pattern search O(m + log n). */
+        llcp.assign(n, 0);
+        rlcp.assign(n, 0);
+        build_search_tree(-1, n);
+    }
+
+    void build_lce_index() {
+        /* Optional O(n log n) sparse table over the LCP array enabling O(1) lce queries. */
+        rank.assign(n, 0);
+        for (int i = 0; i < n; i++) { rank[sa[i]] = i; }
+        sparse.assign(1, lcp);
+        for (int k = 1; (1 << k) <= n; k++) {
+            const auto& prev = sparse[k - 1];
+            std::vector<int> level(n - (1 << k) + 1);
+            for (int i = 0; i < (int)level.size(); i++) {
+                level[i] = std::min(prev[i], prev[i + (1 << (k - 1))]);
+            }
+            sparse.push_back(std::move(level));
+        }
+    }
+
+    int lce(int i, int j) const {
+        /* Longest common prefix of suffixes i and j. Requires build_lce_index(). */
+        if (sparse.empty()) { throw std::runtime_error("build_lce_index() not called"); }
+        if (i == j) { return n - i; }
+        int a = std::min(rank[i], rank[j]) + 1, b = std::max(rank[i], rank[j]);
+        int k = 31 - __builtin_clz(b - a + 1);
+        return std::min(sparse[k][a], sparse[k][b - (1 << k) + 1]);
+    }
+
+    std::vector<int> lce_batch(const std::vector<std::pair<int, int>>& queries) const {
+        std::vector<int> result(queries.size());
+        for (int q = 0; q < (int)queries.size(); q++) {
+            result[q] = lce(queries[q].first, queries[q].second);
+        }
+        return result;
+    }
+
+    const std::vector<int>& get_sa() const {
+        return sa;
+    }
+
+    const std::vector<int>& get_lcp() const {
+        return lcp;
+    }
+
+    void save(const std::string& path, uint32_t width = 0) const {
+        /*
+        Write header, SA and LCP in host byte order, which the header records. Entries are
+        width = 4 or 8 bytes; 0 picks 4, enough for any int index. Load with SuffixArrayView.
+        */
+        if (width == 0) { width = 4; }
+        if (width != 4 && width != 8) { throw std::invalid_argument("width must be 0, 4 or 8"); }
+        SuffixArrayFileHeader header{{'S', 'U', 'F', 'A', 'R', 'R', 'A', 'Y'}, 2, width,
+                                     BYTE_ORDER_MARK, (uint64_t)n, text_hash(text),
+                                     text_hash(text, TEXT_SAMPLES)};
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)&header, sizeof(header));
+        for (const auto* values : {&sa, &lcp}) {
+            if (width == 4) {
+                write_entries<uint32_t>(out, *values);
+            } else {
+                write_entries<uint64_t>(out, *values);
+            }
+        }
+        if (!out) { throw std::runtime_error("failed to write " + path); }
+    }
+};
+
+class SuffixArrayView {
+    /*
+    Read-only suffix array backed by a memory-mapped file written by SuffixArray::save. The
+    mapping is shared, so processes opening the same file share its page cache pages.
+    */
+  private:
+    std::string_view text;
+    void* data = MAP_FAILED;
+    size_t bytes = 0;
+    uint64_t n;
+    uint32_t width;
+    const char* sa_base;
+    const char* lcp_base;
+
+    uint64_t entry(const char* base, uint64_t i) const {
+        if (width == 4) { return ((const uint32_t*)base)[i]; }
+        return ((const uint64_t*)base)[i];
+    }
+
+    uint64_t bound(std::string_view pattern, bool upper) const {
+        uint64_t left = 0, right = n;
+        while (left < right) {
+            uint64_t mid = (left + right) / 2;
+            std::string_view suffix = text.substr(entry(sa_base, mid), pattern.length());
+            int cmp = suffix.compare(pattern);
+            if (cmp < 0 || (upper && cmp == 0)) {
                 left = mid + 1;
             } else {
                 right = mid;
             }
         }
+        return left;
+    }
+
+  public:
+    SuffixArrayView(const std::string& path, std::string_view text, bool verify = false)
+        : text(text) {
+        /*
+        text must outlive the view. Its length and a hash of sampled bytes are checked against
+        the file header; verify = true hashes the whole text instead, an O(n) pass.
+        */
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("cannot open " + path); }
+        struct stat st;
+        if (fstat(fd, &st) == 0) { bytes = st.st_size; }
+        if (bytes >= sizeof(SuffixArrayFileHeader)) {
+            data = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (data == MAP_FAILED) { throw std::runtime_error("cannot map " + path); }
 
-        int start = left;
-        left = start;
-        right = n;
+        const auto* header = (const SuffixArrayFileHeader*)data;
+        n = header->n;
+        width = header->width;
+        bool valid = std::memcmp(header->magic, "SUFARRAY", 8) == 0 && header->version == 2 &&
+                     header->byte_order == BYTE_ORDER_MARK && (width == 4 || width == 8) &&
+                     bytes == sizeof(SuffixArrayFileHeader) + 2 * n * width;
+        bool matches = n == text.length() &&
+                       (verify ? header->text_hash == text_hash(text)
+                               : header->text_sample_hash == text_hash(text, TEXT_SAMPLES));
+        if (!valid || !matches) {
+            munmap(data, bytes);
+            throw std::runtime_error("invalid suffix array file or text mismatch: " + path);
+        }
+        sa_base = (const char*)data + sizeof(SuffixArrayFileHeader);
+        lcp_base = sa_base + n * width;
+    }
 
+    SuffixArrayView(const SuffixArrayView&) = delete;
+    SuffixArrayView& operator=(const SuffixArrayView&) = delete;
+
+    ~SuffixArrayView() {
+        munmap(data, bytes);
+    }
+
+    uint64_t size() const {
+        return n;
+    }
+
+    uint64_t sa_at(uint64_t i) const {
+        return entry(sa_base, i);
+    }
+
+    uint64_t lcp_at(uint64_t i) const {
+        return entry(lcp_base, i);
+    }
+
+    uint64_t count_pattern(std::string_view pattern) const {
+        if (pattern.empty()) { return 0; }
+        return bound(pattern, true) - bound(pattern, false);
+    }
+
+    std::vector<uint64_t> find_pattern(std::string_view pattern) const {
+        if (pattern.empty()) { return {}; }
+        std::vector<uint64_t> result;
+        for (uint64_t i = bound(pattern, false), end = bound(pattern, true); i < end; i++) {
+            result.push_back(sa_at(i));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+class GeneralizedSuffixArray {
+    /*
+    Suffix array over many documents. Document d is followed by its own sentinel symbol d, and
+    byte c is stored as c + D, so sentinels are unique and no match can cross a boundary.
+    */
+  private:
+    int docs;
+    std::vector<int> s;                    // Concatenated symbols
+    std::vector<int> start;                // start[d] = offset of document d in s
+    std::vector<int> sa;                   // Suffix array of s
+    std::vector<int> doc_at;               // doc_at[i] = document of suffix sa[i]
+    std::vector<int> prev_at;              // Previous SA index of the same document or -1
+    std::vector<std::vector<int>> sparse;  // sparse[k][j] = argmin prev_at, blocks [j, j + 2^k)
+
+    static constexpr int BLOCK = 32;  // Argmin inside a block is a scan of at most BLOCK entries
+
+    bool suffix_less(int pos, std::string_view pattern, bool upper) const {
+        // Is suffix pos < pattern? With upper, suffixes starting with pattern also count as less
+        for (int h = 0; h < (int)pattern.length(); h++) {
+            int c = (unsigned char)pattern[h] + docs;
+            if (s[pos + h] != c) { return s[pos + h] < c; }  // Sentinels stop before the end
+        }
+        return upper;
+    }
+
+    int bound(std::string_view pattern, bool upper) const {
+        int left = 0, right = sa.size();
         while (left < right) {
             int mid = (left + right) / 2;
-            std::string suffix = text.substr(sa[mid], std::min(m, n - sa[mid]));
-            if (suffix <= pattern) {
+            if (suffix_less(sa[mid], pattern, upper)) {
                 left = mid + 1;
             } else {
                 right = mid;
             }
         }
+        return left;
+    }
 
-        int end = left;
+    int better(int x, int y) const {
+        return prev_at[x] <= prev_at[y] ? x : y;
+    }
 
-        std::vector<int> result;
-        for (int i = start; i < end; i++) {
-            if (sa[i] + m <= n && text.substr(sa[i], m) == pattern) { result.push_back(sa[i]); }
+    int scan(int a, int b) const {
+        int best = a;
+        for (int i = a + 1; i <= b; i++) { best = better(best, i); }
+        return best;
+    }
+
+    int argmin(int a, int b) const {
+        /* Index of the minimum prev_at in [a, b]: scan partial blocks, look up whole ones. */
+        int ba = a / BLOCK, bb = b / BLOCK;
+        if (bb - ba <= 1) { return scan(a, b); }
+        int best = better(scan(a, (ba + 1) * BLOCK - 1), scan(bb * BLOCK, b));
+        int k = 31 - __builtin_clz(bb - ba - 1);
+        best = better(best, sparse[k][ba + 1]);
+        return better(best, sparse[k][bb - (1 << k)]);
+    }
+
+  public:
+    GeneralizedSuffixArray(const std::vector<std::string>& documents) : docs(documents.size()) {
+        for (int d = 0; d < docs; d++) {
+            start.push_back(s.size());
+            for (char c : documents[d]) { s.push_back((unsigned char)c + docs); }
+            s.push_back(d);
         }
+        start.push_back(s.size());
+        sa = suffix_array_sais(s, docs + 256);
 
+        std::vector<int> doc_of(s.size());
+        for (int d = 0; d < docs; d++) {
+            std::fill(doc_of.begin() + start[d], doc_of.begin() + start[d + 1], d);
+        }
+        doc_at.resize(sa.size());
+        for (int i = 0; i < (int)sa.size(); i++) { doc_at[i] = doc_of[sa[i]]; }
+    }
+
+    std::vector<std::pair<int, int>> find_pattern(std::string_view pattern) const {
+        /* All occurrences as (document id, offset) pairs, sorted. */
+        if (pattern.empty()) { return {}; }
+        std::vector<std::pair<int, int>> result;
+        for (int i = bound(pattern, false), end = bound(pattern, true); i < end; i++) {
+            result.push_back({doc_at[i], sa[i] - start[doc_at[i]]});
+        }
         std::sort(result.begin(), result.end());
         return result;
     }
 
-    const std::vector<int>& get_sa() const {
-        return sa;
+    int count_pattern(std::string_view pattern) const {
+        if (pattern.empty()) { return 0; }
+        return bound(pattern, true) - bound(pattern, false);
     }
 
-    const std::vector<int>& get_lcp() const {
-        return lcp;
+    void build_document_index() {
+        /*
+        Optional index for list_documents: prev_at (n ints) plus a sparse table over block
+        minima, (n / 32) log(n / 32) ints, so about 2n ints in total for n symbols.
+        */
+        int n = sa.size();
+        std::vector<int> last(docs, -1);
+        prev_at.resize(n);
+        for (int i = 0; i < n; i++) {
+            prev_at[i] = last[doc_at[i]];
+            last[doc_at[i]] = i;
+        }
+        int blocks = (n + BLOCK - 1) / BLOCK;
+        sparse.assign(1, std::vector<int>(blocks));
+        for (int j = 0; j < blocks; j++) {
+            sparse[0][j] = scan(j * BLOCK, std::min(n, (j + 1) * BLOCK) - 1);
+        }
+        for (int k = 1; (1 << k) <= blocks; k++) {
+            const auto& prev = sparse[k - 1];
+            std::vector<int> level(blocks - (1 << k) + 1);
+            for (int j = 0; j < (int)level.size(); j++) {
+                level[j] = better(prev[j], prev[j + (1 << (k - 1))]);
+            }
+            sparse.push_back(std::move(level));
+        }
+    }
+
+    std::vector<int> list_documents(std::string_view pattern) const {
+        /*
+        Sorted ids of the documents containing pattern, each reported once, in O(m log n +
+        docs found) time. Requires build_document_index().
+        */
+        if (sparse.empty()) { throw std::runtime_error("build_document_index() not called"); }
+        if (pattern.empty()) { return {}; }
+        int lo = bound(pattern, false), hi = bound(pattern, true) - 1;
+
+        // Muthukrishnan: report each SA index in [lo, hi] whose previous same-document suffix
+        // lies before lo. Every range popped either reports a new document or is dropped.
+        std::vector<int> result;
+        std::vector<std::pair<int, int>> ranges = {{lo, hi}};
+        while (!ranges.empty()) {
+            auto [a, b] = ranges.back();
+            ranges.pop_back();
+            if (a > b) { continue; }
+            int k = argmin(a, b);
+            if (prev_at[k] >= lo) { continue; }
+            result.push_back(doc_at[k]);
+            ranges.push_back({a, k - 1});
+            ranges.push_back({k + 1, b});
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+struct RankBitVector {
+    /* Bit vector with O(1) rank, storing one 32-bit count per 256 bits (12.5% overhead). */
+    std::vector<uint64_t> words;
+    std::vector<uint32_t> blocks;
+
+    RankBitVector(int n = 0) : words(n / 64 + 1, 0) {}
+
+    void set(int i) {
+        words[i >> 6] |= 1ULL << (i & 63);
+    }
+
+    bool get(int i) const {
+        return words[i >> 6] >> (i & 63) & 1;
+    }
+
+    void build() {
+        blocks.assign(words.size() / 4 + 1, 0);
+        uint32_t total = 0;
+        for (int w = 0; w < (int)words.size(); w++) {
+            if (w % 4 == 0) { blocks[w / 4] = total; }
+            total += __builtin_popcountll(words[w]);
+        }
+    }
+
+    int rank1(int i) const {
+        /* Number of set bits in [0, i). */
+        int w = i >> 6;
+        int r = blocks[w >> 2];
+        for (int k = w & ~3; k < w; k++) { r += __builtin_popcountll(words[k]); }
+        return r + __builtin_popcountll(words[w] & ((1ULL << (i & 63)) - 1));
+    }
+};
+
+class FMIndex {
+    /*
+    Compressed full-text index. The BWT of text + '$' is kept in a byte wavelet matrix, and the
+    suffix array is sampled at every sample_rate-th text position. The text is not stored.
+    Uses about 1.3 + 4 / sample_rate bytes per character.
+    */
+  private:
+    int n;  // Text length; BWT rows are 0..n and row 0 is the empty suffix
+    int dollar_row;
+    std::vector<RankBitVector> levels;  // levels[l] holds bit 7 - l of the permuted symbols
+    std::vector<int> zeros;             // Zero bits per level
+    std::vector<int> symbol_begin;      // Start of each symbol's run after the last level
+    std::vector<int> first;             // first[c] = 1 + number of text characters below c
+    RankBitVector sampled;              // Rows whose SA value is stored
+    std::vector<int> samples;           // SA values of sampled rows, in row order
+
+    int occ(int c, int row) const {
+        /* Occurrences of byte c in bwt[0, row). The '$' row holds byte 0 and is excluded. */
+        int end = row;
+        for (int l = 0; l < 8; l++) {
+            int ones = levels[l].rank1(row);
+            row = (c >> (7 - l) & 1) ? zeros[l] + ones : row - ones;
+        }
+        return row - symbol_begin[c] - (c == 0 && dollar_row < end ? 1 : 0);
+    }
+
+    int lf(int row) const {
+        /* Row of the suffix one position earlier in the text. row must not be the '$' row. */
+        int end = row, c = 0;
+        for (int l = 0; l < 8; l++) {
+            int bit = levels[l].get(row);
+            int ones = levels[l].rank1(row);
+            row = bit ? zeros[l] + ones : row - ones;
+            c = c << 1 | bit;
+        }
+        return first[c] + row - symbol_begin[c] - (c == 0 && dollar_row < end ? 1 : 0);
+    }
+
+    std::pair<int, int> find_rows(std::string_view pattern) const {
+        /* Backward search: half-open range of BWT rows whose suffixes start with pattern. */
+        int s = 0, e = n + 1;
+        for (int h = (int)pattern.length() - 1; h >= 0 && s < e; h--) {
+            int c = (unsigned char)pattern[h];
+            s = first[c] + occ(c, s);
+            e = first[c] + occ(c, e);
+        }
+        return {s, std::max(s, e)};
+    }
+
+  public:
+    FMIndex(const std::string& text, int sample_rate = 32)
+        : n(checked_length(text.length())), zeros(8), symbol_begin(256), first(256, 1),
+          sampled(n + 1) {
+        std::vector<int> sa = suffix_array_sais(text);
+
+        // BWT row 0 is the empty suffix, row i + 1 is suffix sa[i]
+        std::vector<unsigned char> bwt(n + 1);
+        bwt[0] = n > 0 ? text[n - 1] : 0;
+        dollar_row = n == 0 ? 0 : -1;
+        for (int i = 0; i < n; i++) {
+            if (sa[i] == 0) {
+                dollar_row = i + 1;
+                bwt[i + 1] = 0;
+            } else {
+                bwt[i + 1] = text[sa[i] - 1];
+            }
+        }
+
+        // Sample rows of text positions divisible by sample_rate (position 0 included)
+        if (n % sample_rate == 0) { sampled.set(0); }
+        for (int i = 0; i < n; i++) {
+            if (sa[i] % sample_rate == 0) { sampled.set(i + 1); }
+        }
+        sampled.build();
+        for (int row = 0; row <= n; row++) {
+            if (sampled.get(row)) { samples.push_back(row == 0 ? n : sa[row - 1]); }
+        }
+        std::vector<int>().swap(sa);
+
+        for (char ch : text) { first[(unsigned char)ch]++; }
+        for (int c = 255, below = n; c >= 0; c--) {
+            below -= first[c] - 1;
+            first[c] = 1 + below;
+        }
+
+        // Wavelet matrix: stable partition by each bit, most significant first
+        std::vector<unsigned char> next(n + 1);
+        for (int l = 0; l < 8; l++) {
+            RankBitVector level(n + 1);
+            int z = 0;
+            for (int i = 0; i <= n; i++) {
+                if (bwt[i] >> (7 - l) & 1) {
+                    level.set(i);
+                } else {
+                    z++;
+                }
+            }
+            level.build();
+            zeros[l] = z;
+            for (int i = 0, lo = 0, hi = z; i <= n; i++) {
+                next[level.get(i) ? hi++ : lo++] = bwt[i];
+            }
+            bwt.swap(next);
+            levels.push_back(std::move(level));
+        }
+        for (int c = 0; c < 256; c++) {
+            int row = 0;
+            for (int l = 0; l < 8; l++) {
+                int ones = levels[l].rank1(row);
+                row = (c >> (7 - l) & 1) ? zeros[l] + ones : row - ones;
+            }
+            symbol_begin[c] = row;
+        }
+    }
+
+    int count(std::string_view pattern) const {
+        /* Number of occurrences in O(m) rank operations. */
+        if (pattern.empty()) { return 0; }
+        auto [s, e] = find_rows(pattern);
+        return e - s;
+    }
+
+    std::vector<int> locate(std::string_view pattern) const {
+        /* Sorted occurrence positions, using at most sample_rate - 1 LF steps per occurrence. */
+        if (pattern.empty()) { return {}; }
+        auto [s, e] = find_rows(pattern);
+        std::vector<int> result;
+        for (int row = s; row < e; row++) {
+            int r = row, steps = 0;
+            while (!sampled.get(r)) {
+                r = lf(r);
+                steps++;
+            }
+            result.push_back(samples[sampled.rank1(r)] + steps);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    size_t size_in_bytes() const {
+        size_t bytes = sampled.words.size() * 8 + sampled.blocks.size() * 4 + samples.size() * 4;
+        for (const auto& level : levels) {
+            bytes += level.words.size() * 8 + level.blocks.size() * 4;
+        }
+        return bytes;
     }
 };
 
@@ -109,10 +1019,27 @@ void test_main() {
 
     auto positions = sa.find_pattern("ana");
     assert(positions == std::vector<int>({1, 3}));
+    assert(sa.count_pattern("an") == 2);
 }
 
 // Don't write tests below during competition.
 
+std::vector<int> naive_suffix_array(const std::string& text) {
+    // The original comparator sort, kept as a reference and benchmark baseline
+    std::vector<int> suffixes(text.length());
+    for (int i = 0; i < (int)text.length(); i++) { suffixes[i] = i; }
+    std::sort(suffixes.begin(), suffixes.end(),
+              [&](int a, int b) { return text.substr(a) < text.substr(b); });
+    return suffixes;
+}
+
+std::string random_text(int n, int alphabet, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string text(n, 'a');
+    for (auto& c : text) { c = (char)(alphabet == 256 ? rng() % 256 : 'a' + rng() % alphabet); }
+    return text;
+}
+
 void test_empty_string() {
     SuffixArray sa("");
     assert(sa.get_sa().empty());
@@ -141,13 +1068,346 @@ void test_overlapping_patterns() {
     assert(positions == std::vector<int>({0, 3, 6}));
 }
 
-int main() {
+void test_matches_naive_sort() {
+    std::string text = "mississippi$abracadabra";
+    for (int i = 0; i < 200; i++) { text += (char)('a' + (i * i + 3 * i) % 3); }
+    SuffixArray sa(text);
+    assert(sa.get_sa() == naive_suffix_array(text));
+}
+
+void test_length_limit() {
+    assert(checked_length(INT_MAX - 1) == INT_MAX - 1);
+    bool caught = false;
+    try {
+        checked_length(INT_MAX);
+    } catch (const std::length_error&) { caught = true; }
+    assert(caught);
+}
+
+void test_construction_engines_agree() {
+    for (int alphabet : {1, 2, 3, 4, 26, 256}) {
+        for (int n : {1, 2, 3, 5, 17, 100, 1000}) {
+            std::string text = random_text(n, alphabet, n * 31 + alphabet);
+            auto expected = naive_suffix_array(text);
+            assert(suffix_array_sais(text) == expected);
+            assert(suffix_array_doubling(text) == expected);
+        }
+    }
+}
+
+void test_integer_alphabet() {
+    std::vector<int> s = {5, 0, 5, 0, 9, 5, 0, 5, 0};
+    std::string as_bytes(s.begin(), s.end());
+    assert(suffix_array_sais(s, 10) == naive_suffix_array(as_bytes));
+
+    std::mt19937 rng(7);
+    std::vector<int> big(5000);
+    for (auto& x : big) { x = rng() % 100000; }
+    auto sa = suffix_array_sais(big, 100000);
+    for (int i = 1; i < (int)sa.size(); i++) {
+        assert(std::lexicographical_compare(big.begin() + sa[i - 1], big.end(),
+                                            big.begin() + sa[i], big.end()));
+    }
+}
+
+void test_large_text() {
+    std::string text(1 << 20, 'a');
+    for (int i = 0; i < (int)text.length(); i += 7) { text[i] = 'b'; }
+    SuffixArray sa(text);
+    const auto& suffixes = sa.get_sa();
+    for (int i = 1; i < 1000; i++) {
+        assert(text.compare(suffixes[i - 1], 64, text, suffixes[i], 64) <= 0);
+    }
+}
+
+void test_search_against_brute_force() {
+    for (int alphabet : {1, 2, 4}) {
+        std::string text = random_text(3000, alphabet, 99 + alphabet);
+        SuffixArray sa(text), indexed(text);
+        indexed.build_search_index();
+        std::mt19937 rng(alphabet);
+        for (int q = 0; q < 300; q++) {
+            int len = 1 + rng() % 12;
+            std::string pattern = q % 2 == 0 ? text.substr(rng() % (text.size() - len), len)
+                                             : random_text(len, alphabet + 1, q);
+            std::vector<int> expected;
+            for (int i = 0; i + len <= (int)text.size(); i++) {
+                if (text.compare(i, len, pattern) == 0) { expected.push_back(i); }
+            }
+            assert(sa.find_pattern(pattern) == expected);
+            assert(sa.count_pattern(pattern) == (int)expected.size());
+            assert(indexed.find_pattern(pattern) == expected);
+        }
+    }
+}
+
+void test_pattern_edge_cases() {
+    SuffixArray sa("abcab");
+    assert(sa.count_pattern("") == 0);
+    assert(sa.count_pattern("abcabx") == 0);  // Longer than any suffix
+    assert(sa.find_pattern("abcab") == std::vector<int>({0}));
+    assert(sa.find_pattern("b") == std::vector<int>({1, 4}));
+    assert(sa.count_pattern("0") == 0);  // Smaller than every suffix
+    assert(sa.count_pattern("z") == 0);  // Larger than every suffix
+
+    sa.build_search_index();
+    assert(sa.count_pattern("abcabx") == 0 && sa.count_pattern("0") == 0);
+    assert(sa.find_pattern("b") == std::vector<int>({1, 4}));
+
+    std::string binary("\x01\xff\x01\xff", 4);
+    SuffixArray bytes(binary);
+    assert(bytes.find_pattern(std::string("\xff", 1)) == std::vector<int>({1, 3}));
+}
+
+void test_lce() {
+    SuffixArray sa("banana");
+    sa.build_lce_index();
+    assert(sa.lce(1, 3) == 3);  // "anana" vs "ana"
+    assert(sa.lce(0, 2) == 0);
+    assert(sa.lce(2, 4) == 2);  // "nana" vs "na"
+    assert(sa.lce(5, 5) == 1);
+    assert(sa.lce_batch({{1, 3}, {3, 1}, {0, 5}}) == std::vector<int>({3, 3, 0}));
+
+    std::string text = random_text(500, 2, 5);
+    SuffixArray big(text);
+    big.build_lce_index();
+    for (int i = 0; i < 500; i += 7) {
+        for (int j = 0; j < 500; j += 3) {
+            int h = 0;
+            while (i + h < 500 && j + h < 500 && text[i + h] == text[j + h]) { h++; }
+            assert(big.lce(i, j) == h);
+        }
+    }
+
+    SuffixArray unbuilt("abc");
+    bool caught = false;
+    try {
+        unbuilt.lce(0, 1);
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+}
+
+void test_generalized_suffix_array() {
+    GeneralizedSuffixArray gsa({"banana", "ananas", "", "nab"});
+    std::vector<std::pair<int, int>> expected = {{0, 1}, {0, 3}, {1, 0}, {1, 2}};
+    assert(gsa.find_pattern("ana") == expected);
+    assert(gsa.count_pattern("ana") == 4);
+    assert(gsa.count_pattern("sb") == 0);    // Would cross the boundary between documents 1 and 3
+    assert(gsa.count_pattern("ab") == 1);    // Only inside "nab"
+    assert(gsa.count_pattern("anab") == 0);  // "banana" + "nab" must not match across documents
+
+    gsa.build_document_index();
+    assert(gsa.list_documents("an") == std::vector<int>({0, 1}));
+    assert(gsa.list_documents("n") == std::vector<int>({0, 1, 3}));
+    assert(gsa.list_documents("x").empty());
+}
+
+void test_generalized_against_brute_force() {
+    std::vector<std::string> documents;
+    for (int d = 0; d < 300; d++) { documents.push_back(random_text(d % 13, 3, d)); }
+    GeneralizedSuffixArray gsa(documents);
+    gsa.build_document_index();
+
+    for (const std::string pattern : {"a", "ab", "cab", "bb", "abcab", "ccc"}) {
+        std::vector<std::pair<int, int>> occurrences;
+        std::vector<int> containing;
+        for (int d = 0; d < (int)documents.size(); d++) {
+            for (size_t p = documents[d].find(pattern); p != std::string::npos;
+                 p = documents[d].find(pattern, p + 1)) {
+                occurrences.push_back({d, (int)p});
+            }
+            if (documents[d].find(pattern) != std::string::npos) { containing.push_back(d); }
+        }
+        assert(gsa.find_pattern(pattern) == occurrences);
+        assert(gsa.list_documents(pattern) == containing);
+    }
+}
+
+void test_list_documents_many() {
+    // Every document matches, and ties make each argmin the leftmost index of its range, so a
+    // recursive split would nest 300000 calls deep
+    std::vector<std::string> documents(300000, "a");
+    GeneralizedSuffixArray gsa(documents);
+    gsa.build_document_index();
+    auto found = gsa.list_documents("a");
+    assert((int)found.size() == 300000);
+    for (int d = 0; d < 300000; d++) { assert(found[d] == d); }
+    assert(gsa.list_documents("aa").empty());
+}
+
+void test_fm_index() {
+    FMIndex fm("banana", 2);
+    assert(fm.count("ana") == 2);
+    assert(fm.locate("ana") == std::vector<int>({1, 3}));
+    assert(fm.locate("banana") == std::vector<int>({0}));
+    assert(fm.count("nab") == 0);
+    assert(fm.count("") == 0);
+
+    FMIndex empty("");
+    assert(empty.count("a") == 0);
+}
+
+void test_fm_index_against_suffix_array() {
+    for (int alphabet : {1, 3, 256}) {
+        std::string text = random_text(4000, alphabet, alphabet);
+        SuffixArray sa(text);
+        for (int rate : {1, 5, 32}) {
+            FMIndex fm(text, rate);
+            std::mt19937 rng(rate);
+            for (int q = 0; q < 100; q++) {
+                int len = 1 + rng() % 6;
+                std::string pattern = text.substr(rng() % (text.size() - len), len);
+                if (q % 3 == 0) { pattern[0] ^= 1; }
+                assert(fm.count(pattern) == sa.count_pattern(pattern));
+                assert(fm.locate(pattern) == sa.find_pattern(pattern));
+            }
+        }
+    }
+
+    std::string text = random_text(1 << 16, 4, 3);
+    FMIndex fm(text, 32);
+    assert(fm.size_in_bytes() < 2 * text.size());
+}
+
+void test_save_and_view() {
+    std::string text = random_text(3000, 3, 11);
+    SuffixArray sa(text);
+    for (uint32_t width : {0u, 8u}) {
+        std::string path = "/tmp/suffix_array_test_" + std::to_string(width) + ".bin";
+        sa.save(path, width);
+        SuffixArrayView view(path, text);
+        assert(view.size() == text.size());
+        for (int i = 0; i < (int)text.size(); i++) {
+            assert(view.sa_at(i) == (uint64_t)sa.get_sa()[i]);
+            assert(view.lcp_at(i) == (uint64_t)sa.get_lcp()[i]);
+        }
+        for (const std::string pattern : {"a", "abc", "cab", "bbbbbbbbbbbbbbbbbbbbb"}) {
+            auto expected = sa.find_pattern(pattern);
+            std::vector<uint64_t> positions(expected.begin(), expected.end());
+            assert(view.find_pattern(pattern) == positions);
+            assert(view.count_pattern(pattern) == expected.size());
+        }
+
+        bool caught = false;
+        try {
+            SuffixArrayView wrong(path, text.substr(1) + "x");
+        } catch (const std::runtime_error&) { caught = true; }
+        assert(caught);
+        std::remove(path.c_str());
+    }
+
+    bool caught = false;
+    try {
+        SuffixArrayView missing("/tmp/suffix_array_missing.bin", text);
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+
+    // Sampling reads every third byte of this text; full verification also sees byte 1
+    std::string longer = random_text(3 * TEXT_SAMPLES, 3, 12), edited = longer;
+    edited[1] = edited[1] == 'a' ? 'b' : 'a';
+    std::string sampled = "/tmp/suffix_array_test_sampled.bin";
+    SuffixArray(longer).save(sampled);
+    SuffixArrayView unverified(sampled, edited);
+    assert(unverified.size() == longer.size());
+    SuffixArrayView verified(sampled, longer, true);
+    caught = false;
+    try {
+        SuffixArrayView mismatch(sampled, edited, true);
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+    std::remove(sampled.c_str());
+
+    for (uint32_t width : {2u, 16u}) {
+        caught = false;
+        try {
+            sa.save("/tmp/suffix_array_bad_width.bin", width);
+        } catch (const std::invalid_argument&) { caught = true; }
+        assert(caught);
+    }
+
+    // A file written with the other byte order is rejected instead of misread
+    std::string path = "/tmp/suffix_array_test_swapped.bin";
+    sa.save(path);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t swapped = __builtin_bswap64(BYTE_ORDER_MARK);
+        file.seekp(offsetof(SuffixArrayFileHeader, byte_order));
+        file.write((const char*)&swapped, sizeof(swapped));
+    }
+    caught = false;
+    try {
+        SuffixArrayView view(path, text);
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+    std::remove(path.c_str());
+}
+
+void test_parallel_construction() {
+    for (int alphabet : {1, 2, 4, 256}) {
+        for (int n : {1, 2, 7, 1000, 20000}) {
+            std::string text = random_text(n, alphabet, n + alphabet);
+            SuffixArray serial(text);
+            for (int threads : {2, 3, 8}) {
+                SuffixArray parallel(text, threads);
+                assert(parallel.get_sa() == serial.get_sa());
+                assert(parallel.get_lcp() == serial.get_lcp());
+            }
+        }
+    }
+    SuffixArray parallel("banana", 4);
+    assert(parallel.find_pattern("ana") == std::vector<int>({1, 3}));
+}
+
+void benchmark(long long max_size) {
+    // Run with: ./suffix_array bench [max_size]. Sizes grow by 4x from 1 KB.
+    auto time_ms = [](auto&& build) {
+        auto start = std::chrono::steady_clock::now();
+        build();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    };
+    int threads = std::max(2u, std::thread::hardware_concurrency());
+    std::cout << "size\tsa-is ms\tdoubling ms\tparallel(" << threads << ") ms\tcomparator ms"
+              << std::endl;
+    for (long long size = 1 << 10; size <= max_size; size *= 4) {
+        std::string text = random_text(size, 4, 1);
+        std::cout << size << "\t" << time_ms([&] { suffix_array_sais(text); }) << "\t"
+                  << time_ms([&] { suffix_array_doubling(text); }) << "\t"
+                  << time_ms([&] { suffix_array_parallel(text, threads); }) << "\t";
+        if (size <= 1 << 16) {
+            std::cout << time_ms([&] { naive_suffix_array(text); }) << std::endl;
+        } else {
+            std::cout << "-" << std::endl;  // Quadratic copies make larger sizes impractical
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark(argc > 2 ? std::stoll(argv[2]) : 1LL << 30);
+        return 0;
+    }
     test_main();
     test_empty_string();
     test_single_char();
     test_repeated_chars();
     test_pattern_not_found();
     test_overlapping_patterns();
+    test_matches_naive_sort();
+    test_length_limit();
+    test_construction_engines_agree();
+    test_integer_alphabet();
+    test_search_against_brute_force();
+    test_pattern_edge_cases();
+    test_lce();
+    test_generalized_suffix_array();
+    test_generalized_against_brute_force();
+    test_list_documents_many();
+    test_fm_index();
+    test_fm_index_against_suffix_array();
+    test_save_and_view();
+    test_parallel_construction();
+    test_large_text();
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }
@@ -0,0 +1,299 @@
+/*
+Suffix automaton: the minimal DFA accepting all suffixes of a string, built online.
+
+Each state is a class of substrings with the same set of end positions. Transitions are stored
+in flat edge arrays indexed by one hash table keyed by (state, character), so large alphabets
+cost no per-state maps.
+Characters may be appended at any time (streaming), and the statistics below stay available.
+
+* count_distinct_substrings: sum of len[v] - len[link[v]] over states, maintained incrementally.
+* occurrences(pattern): number of occurrences, via a DP over the suffix-link tree.
+* longest_repeated_substring: longest substring that occurs at least twice.
+* longest_common_substring(other): by running other through the automaton.
+
+Time complexity: O(n) expected for construction, O(m) per query after an O(n) DP refresh.
+Space complexity: O(n), at most 2n states and 3n transitions.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class SuffixAutomaton {
+  private:
+    std::vector<int> len, link;
+    std::vector<bool> is_clone;
+    std::vector<int> first_end;  // End position of the first occurrence of the state
+    int last = 0;
+    long long distinct = 0;
+
+    // Transitions live in flat edge arrays, chained per state for cloning, and are found through
+    // one open-addressing table keyed by state << 8 | char
+    std::vector<int> head, edge_to, edge_next;
+    std::vector<unsigned char> edge_char;
+    std::vector<uint64_t> keys;
+    std::vector<int> values;  // Edge index per slot
+
+    std::vector<long long> occ;  // occ[v] = |endpos(v)|, valid when occ_size == states
+    int occ_size = 0;
+
+    static constexpr uint64_t EMPTY = ~0ULL;
+
+    size_t find_slot(uint64_t key) const {
+        size_t mask = keys.size() - 1;
+        size_t s = (key * 0x9E3779B97F4A7C15ULL) >> 20 & mask;
+        while (keys[s] != EMPTY && keys[s] != key) { s = (s + 1) & mask; }
+        return s;
+    }
+
+    int next(int v, unsigned char c) const {
+        size_t s = find_slot((uint64_t)v << 8 | c);
+        return keys[s] == EMPTY ? -1 : edge_to[values[s]];
+    }
+
+    void set_next(int v, unsigned char c, int to) {
+        if (2 * (edge_to.size() + 1) > keys.size()) {  // Keep load factor <= 1/2
+            std::vector<uint64_t> old_keys(2 * keys.size(), EMPTY);
+            std::vector<int> old_values(2 * keys.size());
+            old_keys.swap(keys);
+            old_values.swap(values);
+            for (size_t i = 0; i < old_keys.size(); i++) {
+                if (old_keys[i] != EMPTY) {
+                    size_t s = find_slot(old_keys[i]);
+                    keys[s] = old_keys[i];
+                    values[s] = old_values[i];
+                }
+            }
+        }
+        size_t s = find_slot((uint64_t)v << 8 | c);
+        if (keys[s] != EMPTY) {
+            edge_to[values[s]] = to;
+            return;
+        }
+        keys[s] = (uint64_t)v << 8 | c;
+        values[s] = edge_to.size();
+        edge_to.push_back(to);
+        edge_char.push_back(c);
+        edge_next.push_back(head[v]);
+        head[v] = values[s];
+    }
+
+    int new_state(int length, int suffix_link, bool clone, int end) {
+        len.push_back(length);
+        link.push_back(suffix_link);
+        is_clone.push_back(clone);
+        first_end.push_back(end);
+        head.push_back(-1);
+        return len.size() - 1;
+    }
+
+    void refresh_occurrences() {
+        /* endpos sizes: 1 for each non-clone state, summed up the suffix-link tree. */
+        int states = len.size();
+        if (occ_size == states) { return; }
+        std::vector<int> order(states), bucket(len[last] + 2, 0);
+        for (int v = 0; v < states; v++) { bucket[len[v]]++; }
+        for (int i = 1; i < (int)bucket.size(); i++) { bucket[i] += bucket[i - 1]; }
+        for (int v = states - 1; v >= 0; v--) { order[--bucket[len[v]]] = v; }
+
+        occ.assign(states, 0);
+        for (int v = 1; v < states; v++) { occ[v] = is_clone[v] ? 0 : 1; }
+        for (int i = states - 1; i > 0; i--) { occ[link[order[i]]] += occ[order[i]]; }
+        occ_size = states;
+    }
+
+  public:
+    SuffixAutomaton(std::string_view text = "") : keys(16, EMPTY), values(16) {
+        new_state(0, -1, false, -1);
+        extend(text);
+    }
+
+    void extend(char ch) {
+        /* Append one character in amortized O(1). */
+        unsigned char c = ch;
+        int cur = new_state(len[last] + 1, 0, false, len[last]);
+        int p = last;
+        while (p != -1 && next(p, c) == -1) {
+            set_next(p, c, cur);
+            p = link[p];
+        }
+        if (p != -1) {
+            int q = next(p, c);
+            if (len[p] + 1 == len[q]) {
+                link[cur] = q;
+            } else {
+                int clone = new_state(len[p] + 1, link[q], true, first_end[q]);
+                for (int e = head[q]; e != -1; e = edge_next[e]) {
+                    set_next(clone, edge_char[e], edge_to[e]);
+                }
+                while (p != -1 && next(p, c) == q) {
+                    set_next(p, c, clone);
+                    p = link[p];
+                }
+                link[q] = link[cur] = clone;
+            }
+        }
+        last = cur;
+        distinct += len[cur] - len[link[cur]];
+    }
+
+    void extend(std::string_view text) {
+        for (char c : text) { extend(c); }
+    }
+
+    long long count_distinct_substrings() const {
+        /* Number of distinct non-empty substrings, in O(1). */
+        return distinct;
+    }
+
+    long long occurrences(std::string_view pattern) {
+        /* Number of occurrences of pattern (overlapping), O(m) after an O(n) refresh. */
+        refresh_occurrences();
+        int v = 0;
+        for (char c : pattern) {
+            v = next(v, c);
+            if (v == -1) { return 0; }
+        }
+        return pattern.empty() ? 0 : occ[v];
+    }
+
+    std::pair<int, int> longest_repeated_substring() {
+        /* (start, length) of a longest substring occurring at least twice; length 0 if none. */
+        refresh_occurrences();
+        int best = 0;
+        for (int v = 1; v < (int)len.size(); v++) {
+            if (occ[v] >= 2 && len[v] > len[best]) { best = v; }
+        }
+        return {first_end[best] - len[best] + 1, len[best]};
+    }
+
+    std::pair<int, int> longest_common_substring(std::string_view other) const {
+        /*
+        (start in other, length) of a longest substring of other that also occurs in the
+        indexed text, in O(|other|).
+        */
+        int v = 0, l = 0, best = 0, best_end = -1;
+        for (int i = 0; i < (int)other.length(); i++) {
+            unsigned char c = other[i];
+            while (v != 0 && next(v, c) == -1) {
+                v = link[v];
+                l = len[v];
+            }
+            if (next(v, c) != -1) {
+                v = next(v, c);
+                l++;
+            }
+            if (l > best) {
+                best = l;
+                best_end = i;
+            }
+        }
+        return {best_end - best + 1, best};
+    }
+
+    int size() const {
+        return len.size();
+    }
+};
+
+void test_main() {
+    SuffixAutomaton sam("abcbc");
+    assert(sam.count_distinct_substrings() == 12);
+    assert(sam.occurrences("bc") == 2);
+    assert(sam.occurrences("cb") == 1);
+    assert(sam.occurrences("bd") == 0);
+    assert(sam.longest_repeated_substring() == std::make_pair(1, 2));        // "bc"
+    assert(sam.longest_common_substring("xxcbcx") == std::make_pair(2, 3));  // "cbc"
+}
+
+// Don't write tests below during competition.
+
+long long brute_distinct(const std::string& s) {
+    std::set<std::string> seen;
+    for (size_t i = 0; i < s.size(); i++) {
+        for (size_t j = i + 1; j <= s.size(); j++) { seen.insert(s.substr(i, j - i)); }
+    }
+    return seen.size();
+}
+
+long long brute_occurrences(const std::string& s, const std::string& p) {
+    long long count = 0;
+    for (size_t i = s.find(p); i != std::string::npos; i = s.find(p, i + 1)) { count++; }
+    return count;
+}
+
+void test_empty() {
+    SuffixAutomaton sam;
+    assert(sam.count_distinct_substrings() == 0);
+    assert(sam.occurrences("a") == 0);
+    assert(sam.occurrences("") == 0);
+    assert(sam.longest_repeated_substring().second == 0);
+    assert(sam.longest_common_substring("abc").second == 0);
+}
+
+void test_repeated_chars() {
+    SuffixAutomaton sam("aaaa");
+    assert(sam.count_distinct_substrings() == 4);
+    assert(sam.occurrences("aa") == 3);
+    assert(sam.longest_repeated_substring() == std::make_pair(0, 3));
+}
+
+void test_streaming_against_brute_force() {
+    std::mt19937 rng(17);
+    SuffixAutomaton sam;
+    std::string text;
+    for (int step = 0; step < 300; step++) {
+        char c = 'a' + rng() % 3;
+        sam.extend(c);
+        text += c;
+        if (step % 25 != 0) { continue; }
+        assert(sam.count_distinct_substrings() == brute_distinct(text));
+        for (int q = 0; q < 20; q++) {
+            std::string p;
+            for (int k = 1 + rng() % 4; k > 0; k--) { p += (char)('a' + rng() % 3); }
+            assert(sam.occurrences(p) == brute_occurrences(text, p));
+        }
+        auto [start, length] = sam.longest_repeated_substring();
+        if (length > 0) {
+            assert(brute_occurrences(text, text.substr(start, length)) >= 2);
+        }
+        for (size_t i = 0; i + length + 1 <= text.size(); i++) {
+            assert(brute_occurrences(text, text.substr(i, length + 1)) < 2);
+        }
+    }
+    assert(sam.size() <= 2 * (int)text.size());
+}
+
+void test_longest_common_substring() {
+    SuffixAutomaton sam("the quick brown fox");
+    auto [start, length] = sam.longest_common_substring("a quick brawn dog");
+    assert(start == 1 && length == 9);  // " quick br"
+    assert(sam.longest_common_substring("zzz").second == 0);
+}
+
+void test_binary_alphabet_bytes() {
+    std::string text;
+    for (int i = 0; i < 512; i++) { text += (char)(i * 7 % 256); }
+    SuffixAutomaton sam(text);
+    assert(sam.occurrences(std::string(1, (char)0)) == 2);
+    assert(sam.occurrences(text.substr(100, 50)) == 2);  // The text has period 256
+    assert(sam.longest_repeated_substring() == std::make_pair(0, 256));
+}
+
+int main() {
+    test_main();
+    test_empty();
+    test_repeated_chars();
+    test_streaming_against_brute_force();
+    test_longest_common_substring();
+    test_binary_alphabet_bytes();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
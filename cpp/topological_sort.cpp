@@ -5,54 +5,190 @@ Produces a linear ordering of vertices such that for every directed edge (u, v),
 vertex u comes before v in the ordering. Uses both DFS-based and Kahn's algorithm
 (BFS-based) approaches for different use cases.
 
-Time complexity: O(V + E) for both algorithms, where V is vertices and E is edges.
+Nodes get dense ids and the edges are frozen into a CSR (compressed sparse row) array on first
+use, ranked in NodeT order so results match the order of the node keys. The DFS is iterative,
+and in-degree counts live in a reusable array. lexicographic_sort() uses a min-heap of ready
+nodes to return the smallest ordering.
+
+execute() runs a callable per node on a work-stealing thread pool. Each task starts as soon as
+its atomic in-degree counter reaches zero, and the run reports per-task timing and the critical
+path, the chain of dependent tasks with the largest total duration.
+
+weighted_longest_path() finds heaviest paths with node weights (default 1) and edge weights
+(default 0) and reconstructs them. levels() partitions the nodes into antichains by depth, the
+number of edges on a longest path from a source, returned as one flat array with offsets.
+
+transitive_reduction() drops every edge implied by another path. Nodes are visited in reverse
+topological order, and each gets a reachability bitset: the OR of its children's, taken in
+topological order, so an edge is redundant exactly when an earlier child already reaches its
+target. Target columns are processed in blocks to bound memory.
+
+DynamicTopologicalOrder keeps an order under edge insertions (Pearce-Kelly): an edge against the
+order only reorders the nodes between its endpoints that the edge affects, and edges that would
+close a cycle are rejected.
+
+Time complexity: O(V + E) for both algorithms, where V is vertices and E is edges, plus
+O(E log V) to map node keys and O(V log V) for lexicographic_sort. transitive_reduction takes
+O(V * E / 64) word operations.
 Space complexity: O(V + E) for the graph representation and auxiliary data structures.
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <random>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
+template <typename NodeT>
+struct ExecutionReport {
+    std::vector<NodeT> nodes;                   // Task per index, in node order
+    std::vector<double> start_ms, duration_ms;  // Per index, relative to the start of the run
+    std::vector<NodeT> critical_path;           // Dependent chain with the largest total duration
+    double critical_path_ms = 0, wall_ms = 0;
+};
+
+template <typename NodeT>
+struct LongestPaths {
+    std::vector<NodeT> nodes;     // In topological order
+    std::vector<long long> dist;  // Heaviest path ending at nodes[i], including both end nodes
+    std::vector<int> parent;      // Previous index on that path, -1 if it starts at nodes[i]
+    int best = -1;                // Index where the heaviest path overall ends, -1 if empty
+
+    std::vector<NodeT> path_to(int i) const {
+        std::vector<NodeT> path;
+        for (; i != -1; i = parent[i]) { path.push_back(nodes[i]); }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::vector<NodeT> critical_path() const {
+        return path_to(best);
+    }
+};
+
+template <typename NodeT>
+struct Levels {
+    std::vector<NodeT> nodes;  // Level k is nodes[offsets[k]..offsets[k + 1])
+    std::vector<int> offsets;
+};
+
+template <typename NodeT>
+struct CsrGraph {
+    std::vector<NodeT> nodes;  // Out-edges of nodes[i] lead to nodes[targets[offsets[i]..]]
+    std::vector<int> offsets, targets;
+};
+
 template <typename NodeT>
 class TopologicalSort {
   private:
-    std::map<NodeT, std::vector<NodeT>> graph;
-    std::map<NodeT, int> in_degree;
-
-    enum Color { WHITE, GRAY, BLACK };
+    std::map<NodeT, int> ids;  // Dense id per node, in order of first appearance
+    std::vector<NodeT> nodes;  // nodes[id]
+    std::vector<std::pair<int, int>> edges;
+    std::vector<long long> edge_weight;  // Parallel to edges
+    std::vector<long long> node_weight;  // Per id, default 1
+
+    // Frozen graph over ranks (position of the node in NodeT order), rebuilt after changes
+    int frozen_nodes = -1, frozen_edges = -1;
+    std::vector<int> sorted;            // sorted[rank] = id
+    std::vector<int> offsets, targets;  // CSR: out-edges of rank r are targets[offsets[r]..]
+    std::vector<long long> weights;     // Parallel to targets
+    std::vector<int> base_in_degree;
+
+    // Scratch reused across calls
+    std::vector<int> in_deg, edge_pos, order;
+
+    int id_of(const NodeT& node) {
+        auto [it, inserted] = ids.try_emplace(node, nodes.size());
+        if (inserted) {
+            nodes.push_back(node);
+            node_weight.push_back(1);
+        }
+        return it->second;
+    }
 
-    bool dfs_helper(NodeT node, std::map<NodeT, Color>& color, std::vector<NodeT>& result) {
-        if (color[node] == GRAY) {  // Back edge (cycle)
-            return false;
+    void freeze() {
+        /* Build the CSR in rank space; neighbors keep their insertion order. */
+        int n = nodes.size();
+        if (n == frozen_nodes && (int)edges.size() == frozen_edges) { return; }
+        std::vector<int> rank(n);
+        sorted.clear();
+        for (const auto& [node, id] : ids) {
+            rank[id] = sorted.size();
+            sorted.push_back(id);
         }
-        if (color[node] == BLACK) {  // Already processed
-            return true;
+        offsets.assign(n + 1, 0);
+        for (const auto& [u, v] : edges) { offsets[rank[u] + 1]++; }
+        for (int i = 0; i < n; i++) { offsets[i + 1] += offsets[i]; }
+        targets.resize(edges.size());
+        weights.resize(edges.size());
+        edge_pos.assign(offsets.begin(), offsets.end() - 1);
+        for (int e = 0; e < (int)edges.size(); e++) {
+            int pos = edge_pos[rank[edges[e].first]]++;
+            targets[pos] = rank[edges[e].second];
+            weights[pos] = edge_weight[e];
         }
+        base_in_degree.assign(n, 0);
+        for (int t : targets) { base_in_degree[t]++; }
+        frozen_nodes = n;
+        frozen_edges = edges.size();
+    }
 
-        color[node] = GRAY;
-        for (const auto& neighbor : graph[node]) {
-            if (!dfs_helper(neighbor, color, result)) { return false; }
+    bool kahn() {
+        /* Kahn's algorithm into order (ranks), using order itself as the FIFO queue. */
+        freeze();
+        int n = nodes.size();
+        in_deg.assign(base_in_degree.begin(), base_in_degree.end());
+        order.clear();
+        for (int r = 0; r < n; r++) {
+            if (in_deg[r] == 0) { order.push_back(r); }
         }
+        for (int i = 0; i < (int)order.size(); i++) {
+            for (int e = offsets[order[i]]; e < offsets[order[i] + 1]; e++) {
+                if (--in_deg[targets[e]] == 0) { order.push_back(targets[e]); }
+            }
+        }
+        return (int)order.size() == n;
+    }
 
-        color[node] = BLACK;
-        result.push_back(node);
-        return true;
+    std::vector<NodeT> to_nodes(const std::vector<int>& ranks) const {
+        std::vector<NodeT> result;
+        result.reserve(ranks.size());
+        for (int r : ranks) { result.push_back(nodes[sorted[r]]); }
+        return result;
     }
 
   public:
-    void add_edge(NodeT u, NodeT v) {
-        graph.try_emplace(u, std::vector<NodeT>{});
-        in_degree.try_emplace(u, 0);
-        in_degree.try_emplace(v, 0);
-        graph.try_emplace(v, std::vector<NodeT>{});
+    void add_edge(NodeT u, NodeT v, long long weight = 0) {
+        int a = id_of(u);
+        int b = id_of(v);
+        edges.push_back({a, b});
+        edge_weight.push_back(weight);
+    }
+
+    void add_node(NodeT node) {
+        /* Register a node, possibly without edges. */
+        id_of(node);
+    }
 
-        graph[u].push_back(v);
-        in_degree[v]++;
+    void set_weight(NodeT node, long long weight) {
+        /* Weight of node in weighted_longest_path (default 1); registers the node if new. */
+        node_weight[id_of(node)] = weight;
     }
 
     std::optional<std::vector<NodeT>> kahn_sort() {
@@ -61,74 +197,471 @@ class TopologicalSort {
 
         Returns the topological ordering, or nullopt if the graph has a cycle.
         */
-        std::map<NodeT, int> in_deg = in_degree;
-        std::queue<NodeT> q;
+        if (!kahn()) { return std::nullopt; }
+        return to_nodes(order);
+    }
 
-        for (const auto& [node, deg] : in_deg) {
-            if (deg == 0) { q.push(node); }
-        }
+    std::optional<std::vector<NodeT>> dfs_sort() {
+        /*
+        Topological sort using DFS, with an explicit stack so depth is unlimited.
 
-        std::vector<NodeT> result;
+        Returns the topological ordering, or nullopt if the graph has a cycle.
+        */
+        freeze();
+        int n = nodes.size();
+        enum Color : char { WHITE, GRAY, BLACK };
+        std::vector<char> color(n, WHITE);
+        edge_pos.assign(offsets.begin(), offsets.end() - 1);
+        order.clear();
+        std::vector<int> stack;
+
+        for (int root = 0; root < n; root++) {
+            if (color[root] != WHITE) { continue; }
+            color[root] = GRAY;
+            stack.push_back(root);
+            while (!stack.empty()) {
+                int v = stack.back();
+                if (edge_pos[v] < offsets[v + 1]) {
+                    int w = targets[edge_pos[v]++];
+                    if (color[w] == GRAY) { return std::nullopt; }  // Back edge (cycle)
+                    if (color[w] == WHITE) {
+                        color[w] = GRAY;
+                        stack.push_back(w);
+                    }
+                    continue;
+                }
+                color[v] = BLACK;
+                order.push_back(v);
+                stack.pop_back();
+            }
+        }
 
-        while (!q.empty()) {
-            NodeT node = q.front();
-            q.pop();
-            result.push_back(node);
+        std::reverse(order.begin(), order.end());
+        return to_nodes(order);
+    }
 
-            for (const auto& neighbor : graph[node]) {
-                in_deg[neighbor]--;
-                if (in_deg[neighbor] == 0) { q.push(neighbor); }
+    std::optional<std::vector<NodeT>> lexicographic_sort() {
+        /*
+        Lexicographically smallest topological ordering (by NodeT order), using a min-heap of
+        ready nodes. O((V + E) + V log V). Returns nullopt if the graph has a cycle.
+        */
+        freeze();
+        int n = nodes.size();
+        in_deg.assign(base_in_degree.begin(), base_in_degree.end());
+        order.clear();
+        std::vector<int> heap;
+        for (int r = 0; r < n; r++) {
+            if (in_deg[r] == 0) { heap.push_back(r); }  // Ascending: already a min-heap
+        }
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<int>());
+            int v = heap.back();
+            heap.pop_back();
+            order.push_back(v);
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                if (--in_deg[targets[e]] == 0) {
+                    heap.push_back(targets[e]);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<int>());
+                }
             }
         }
+        if ((int)order.size() != n) { return std::nullopt; }
+        return to_nodes(order);
+    }
+
+    bool has_cycle() {
+        return !kahn();
+    }
 
-        // Check if all nodes are processed (no cycle)
-        if (result.size() != in_degree.size()) { return std::nullopt; }
+    std::map<NodeT, int> longest_path() {
+        /*
+        Find longest path from each node in the DAG.
 
+        Returns a map from each node to its longest path length.
+        */
+        if (!kahn()) { throw std::runtime_error("Graph contains a cycle"); }
+
+        std::vector<int> dist(nodes.size(), 0);
+        for (int v : order) {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                dist[targets[e]] = std::max(dist[targets[e]], dist[v] + 1);
+            }
+        }
+
+        std::map<NodeT, int> result;
+        for (int r = 0; r < (int)nodes.size(); r++) {
+            result.emplace_hint(result.end(), nodes[sorted[r]], dist[r]);
+        }
         return result;
     }
 
-    std::optional<std::vector<NodeT>> dfs_sort() {
+    template <typename F>
+    ExecutionReport<NodeT> execute(const F& task, int threads = 1) {
         /*
-        Topological sort using DFS.
+        Run task(node) for every node, each once all its predecessors have finished, on
+        threads workers. Ready tasks go to the finishing worker's deque; idle workers steal from
+        the other end of other deques.
 
-        Returns the topological ordering, or nullopt if the graph has a cycle.
-        */
-        std::map<NodeT, Color> color;
-        for (const auto& [node, _] : in_degree) { color[node] = WHITE; }
+        Throws runtime_error before running anything if the graph has a cycle. An exception
+        from a task stops further scheduling (its dependents never run) and is rethrown once the
+        workers have stopped. Idle workers sleep rather than spin.
 
-        std::vector<NodeT> result;
+        Tasks must not call into this TopologicalSort while it runs: the workers read the CSR
+        and node list, and the other members reuse shared scratch arrays.
+        */
+        using Clock = std::chrono::steady_clock;
+        // Kahn's algorithm up front: rejects cycles and gives the order for the critical path
+        if (!kahn()) { throw std::runtime_error("Graph contains a cycle"); }
+        int n = nodes.size();
+        ExecutionReport<NodeT> report;
+        for (int id : sorted) { report.nodes.push_back(nodes[id]); }
+        std::vector<std::atomic<int>> remaining(n);
+        for (int v = 0; v < n; v++) { remaining[v] = base_in_degree[v]; }
+
+        threads = std::max(threads, 1);
+        struct Queue {
+            std::mutex lock;
+            std::deque<int> tasks;
+        };
+        std::vector<Queue> queues(threads);
+        for (int v = 0, t = 0; v < n; v++) {
+            if (remaining[v] == 0) { queues[t++ % threads].tasks.push_back(v); }
+        }
 
-        for (const auto& [node, _] : in_degree) {
-            if (color[node] == WHITE && !dfs_helper(node, color, result)) { return std::nullopt; }
+        report.start_ms.assign(n, 0);
+        report.duration_ms.assign(n, 0);
+        std::atomic<int> finished{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex error_lock;
+        auto start = Clock::now();
+        auto ms = [&](Clock::time_point t) {
+            return std::chrono::duration<double, std::milli>(t - start).count();
+        };
+
+        // Idle workers sleep on idle_cv until a task is queued or the run ends; the predicate's
+        // inputs are only raised under idle_lock, so no wakeup is lost
+        std::mutex idle_lock;
+        std::condition_variable idle_cv;
+        std::atomic<int> queued{0};
+        for (const auto& queue : queues) { queued += queue.tasks.size(); }
+        auto over = [&] { return finished.load() == n || failed.load(); };
+
+        auto worker = [&](int t) {
+            while (!over()) {
+                int v = -1;
+                {
+                    std::lock_guard<std::mutex> guard(queues[t].lock);
+                    if (!queues[t].tasks.empty()) {
+                        v = queues[t].tasks.back();
+                        queues[t].tasks.pop_back();
+                    }
+                }
+                for (int k = 1; v == -1 && k < threads; k++) {
+                    Queue& victim = queues[(t + k) % threads];
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (!victim.tasks.empty()) {
+                        v = victim.tasks.front();
+                        victim.tasks.pop_front();
+                    }
+                }
+                if (v == -1) {
+                    std::unique_lock<std::mutex> guard(idle_lock);
+                    idle_cv.wait(guard, [&] { return queued.load() > 0 || over(); });
+                    continue;
+                }
+                queued--;
+                if (failed.load()) { return; }  // Another task failed after this one was queued
+
+                auto begin = Clock::now();
+                bool ok = true;
+                try {
+                    task(nodes[sorted[v]]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if (!error) { error = std::current_exception(); }
+                    ok = false;
+                }
+                report.start_ms[v] = ms(begin);
+                report.duration_ms[v] = ms(Clock::now()) - report.start_ms[v];
+                if (!ok) {  // Dependents of a failed task are never released
+                    {
+                        std::lock_guard<std::mutex> guard(idle_lock);
+                        failed = true;
+                    }
+                    idle_cv.notify_all();
+                    return;
+                }
+
+                for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                    if (--remaining[targets[e]] == 0) {
+                        {
+                            std::lock_guard<std::mutex> guard(queues[t].lock);
+                            queues[t].tasks.push_back(targets[e]);
+                        }
+                        {
+                            std::lock_guard<std::mutex> guard(idle_lock);
+                            queued++;
+                        }
+                        idle_cv.notify_one();
+                    }
+                }
+                bool last;
+                {
+                    std::lock_guard<std::mutex> guard(idle_lock);
+                    last = ++finished == n;
+                }
+                if (last) { idle_cv.notify_all(); }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) { pool.emplace_back(worker, t); }
+        worker(0);
+        for (auto& thread : pool) { thread.join(); }
+        if (error) { std::rethrow_exception(error); }
+        report.wall_ms = ms(Clock::now());
+
+        // Critical path: heaviest chain by duration, over the Kahn order
+        std::vector<double> finish(n, 0);
+        std::vector<int> parent(n, -1);
+        int last = -1;
+        for (int v : order) {
+            finish[v] += report.duration_ms[v];
+            if (last == -1 || finish[v] > finish[last]) { last = v; }
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                int w = targets[e];
+                if (parent[w] == -1 || finish[v] > finish[w]) {
+                    finish[w] = finish[v];
+                    parent[w] = v;
+                }
+            }
         }
+        auto& path = report.critical_path;
+        for (int v = last; v != -1; v = parent[v]) { path.push_back(nodes[sorted[v]]); }
+        std::reverse(path.begin(), path.end());
+        report.critical_path_ms = last == -1 ? 0 : finish[last];
+        return report;
+    }
 
-        std::reverse(result.begin(), result.end());
+    LongestPaths<NodeT> weighted_longest_path() {
+        /*
+        Heaviest path ending at every node, where a path weighs the sum of its node and edge
+        weights. Throws runtime_error on a cycle.
+        */
+        if (!kahn()) { throw std::runtime_error("Graph contains a cycle"); }
+
+        int n = nodes.size();
+        LongestPaths<NodeT> result;
+        result.nodes = to_nodes(order);
+        std::vector<int> index(n);  // Position of each rank in the order
+        for (int i = 0; i < n; i++) { index[order[i]] = i; }
+        result.dist.resize(n);
+        result.parent.assign(n, -1);
+        for (int i = 0; i < n; i++) { result.dist[i] = node_weight[sorted[order[i]]]; }
+        // Heaviest path into i, excluding its own weight; 0 means the path starts at i, which
+        // beats incoming paths of negative weight
+        std::vector<long long> best_in(n, 0);
+
+        for (int i = 0; i < n; i++) {
+            result.dist[i] += best_in[i];
+            if (result.best == -1 || result.dist[i] > result.dist[result.best]) { result.best = i; }
+            for (int e = offsets[order[i]]; e < offsets[order[i] + 1]; e++) {
+                int j = index[targets[e]];
+                long long through = result.dist[i] + weights[e];
+                if (through > best_in[j]) {
+                    best_in[j] = through;
+                    result.parent[j] = i;
+                }
+            }
+        }
         return result;
     }
 
-    bool has_cycle() {
-        return !kahn_sort().has_value();
+    Levels<NodeT> levels() {
+        /*
+        Antichains by depth: level k holds the nodes whose longest path from a source has k
+        edges. Every edge goes to a later level, so each level can run as one batch, and the
+        number of levels bounds the makespan with unit tasks from below. Throws on a cycle.
+        */
+        if (!kahn()) { throw std::runtime_error("Graph contains a cycle"); }
+        // Kahn's FIFO order already runs level by level; cut it where the depth changes
+        int n = nodes.size();
+        std::vector<int> depth(n, 0);
+        Levels<NodeT> result;
+        result.offsets = {0};
+        for (int i = 0; i < n; i++) {
+            int v = order[i];
+            if (i > 0 && depth[v] != depth[order[i - 1]]) { result.offsets.push_back(i); }
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                depth[targets[e]] = std::max(depth[targets[e]], depth[v] + 1);
+            }
+        }
+        if (n > 0) { result.offsets.push_back(n); }
+        result.nodes = to_nodes(order);
+        return result;
     }
 
-    std::map<NodeT, int> longest_path() {
+    CsrGraph<NodeT> transitive_reduction(size_t max_bytes = 1 << 28) {
         /*
-        Find longest path from each node in the DAG.
-
-        Returns a map from each node to its longest path length.
+        The DAG without edges implied by longer paths (duplicates included), with nodes in
+        NodeT order and each node's targets in topological order. Reachability bitsets use at
+        most about max_bytes at a time. Throws runtime_error on a cycle.
         */
-        auto topo_order = kahn_sort();
-        if (!topo_order.has_value()) { throw std::runtime_error("Graph contains a cycle"); }
+        if (!kahn()) { throw std::runtime_error("Graph contains a cycle"); }
+        int n = nodes.size();
+        std::vector<int> pos(n);  // Topological position per rank
+        for (int i = 0; i < n; i++) { pos[order[i]] = i; }
+
+        // Children by position, sorted, in a CSR indexed by position
+        std::vector<int> child_offsets(n + 1, 0), children(targets.size());
+        for (int i = 0; i < n; i++) {
+            int r = order[i];
+            child_offsets[i + 1] = child_offsets[i] + offsets[r + 1] - offsets[r];
+            for (int e = offsets[r]; e < offsets[r + 1]; e++) {
+                children[child_offsets[i] + e - offsets[r]] = pos[targets[e]];
+            }
+            std::sort(children.begin() + child_offsets[i], children.begin() + child_offsets[i + 1]);
+        }
 
-        std::map<NodeT, int> dist;
-        for (const auto& [node, _] : in_degree) { dist[node] = 0; }
+        std::vector<char> redundant(children.size(), 0);
+        int width = std::max<size_t>(1, max_bytes / (sizeof(uint64_t) * std::max(n, 1)));
+        std::vector<uint64_t> rows;
+        for (int lo = 0; lo < n; lo += 64 * width) {
+            // Positions [lo, hi) are this block's columns; only p < hi can reach them
+            int hi = std::min<long long>(n, lo + 64LL * width);
+            int words = (hi - lo + 63) / 64;
+            rows.assign((size_t)hi * words, 0);
+            for (int p = hi - 1; p >= 0; p--) {
+                uint64_t* row = &rows[(size_t)p * words];
+                for (int e = child_offsets[p]; e < child_offsets[p + 1]; e++) {
+                    int c = children[e];
+                    if (c >= hi) { break; }
+                    if (c >= lo && (row[(c - lo) >> 6] >> ((c - lo) & 63) & 1)) {
+                        redundant[e] = 1;  // An earlier child reaches c
+                        continue;
+                    }
+                    const uint64_t* reach = &rows[(size_t)c * words];
+                    for (int k = std::max(0, (c - lo) >> 6); k < words; k++) { row[k] |= reach[k]; }
+                }
+                if (p >= lo) { row[(p - lo) >> 6] |= 1ULL << ((p - lo) & 63); }
+            }
+        }
 
-        for (const auto& node : topo_order.value()) {
-            for (const auto& neighbor : graph[node]) {
-                dist[neighbor] = std::max(dist[neighbor], dist[node] + 1);
+        CsrGraph<NodeT> result;
+        for (int id : sorted) { result.nodes.push_back(nodes[id]); }
+        result.offsets.assign(n + 1, 0);
+        for (int r = 0; r < n; r++) {
+            int i = pos[r];
+            for (int e = child_offsets[i]; e < child_offsets[i + 1]; e++) {
+                if (!redundant[e]) { result.targets.push_back(order[children[e]]); }
             }
+            result.offsets[r + 1] = result.targets.size();
+        }
+        return result;
+    }
+};
+
+template <typename NodeT>
+class DynamicTopologicalOrder {
+    /*
+    Topological order under edge insertions (Pearce-Kelly). For an edge u -> v with v before u,
+    a forward search from v and a backward search from u visit only nodes positioned between
+    them. If the forward search reaches u the edge would close a cycle and is rejected.
+    Otherwise the nodes reaching u take the lowest of the visited positions and the nodes
+    reachable from v the highest, each group keeping its relative order.
+    */
+  private:
+    std::map<NodeT, int> ids;
+    std::vector<NodeT> nodes;
+    std::vector<std::vector<int>> out, in;  // Accepted edges per node id
+    std::vector<int> ord;                   // Position per node id
+    std::vector<int> slot;                  // slot[position] = node id
+    std::vector<int> mark;                  // Search stamps per node id
+    int stamp = 0;
+
+    int id_of(const NodeT& node) {
+        auto [it, inserted] = ids.try_emplace(node, nodes.size());
+        if (inserted) {
+            int v = nodes.size();
+            nodes.push_back(node);
+            out.emplace_back();
+            in.emplace_back();
+            ord.push_back(v);
+            slot.push_back(v);
+            mark.push_back(0);
         }
+        return it->second;
+    }
 
-        return dist;
+    bool search(int start, int bound, bool forward, int target, std::vector<int>& found) {
+        /*
+        Nodes reachable from start (or reaching it, backward) with ord < bound (> bound
+        backward). Returns false as soon as target is reached.
+        */
+        std::vector<int> todo = {start};
+        mark[start] = stamp;
+        found.push_back(start);
+        while (!todo.empty()) {
+            int x = todo.back();
+            todo.pop_back();
+            for (int w : forward ? out[x] : in[x]) {
+                if (w == target) { return false; }
+                bool inside = forward ? ord[w] < bound : ord[w] > bound;
+                if (mark[w] != stamp && inside) {
+                    mark[w] = stamp;
+                    found.push_back(w);
+                    todo.push_back(w);
+                }
+            }
+        }
+        return true;
+    }
+
+  public:
+    bool add_edge(NodeT u, NodeT v) {
+        /*
+        Insert u -> v and restore the order. Returns false, leaving the edge out, if it would
+        close a cycle (the nodes themselves are still registered).
+        */
+        int a = id_of(u);
+        int b = id_of(v);
+        if (a == b) { return false; }
+        if (ord[a] > ord[b]) {
+            std::vector<int> fwd, bwd;
+            ++stamp;
+            if (!search(b, ord[a], true, a, fwd)) { return false; }
+            ++stamp;
+            search(a, ord[b], false, -1, bwd);
+
+            auto by_ord = [&](int x, int y) { return ord[x] < ord[y]; };
+            std::sort(fwd.begin(), fwd.end(), by_ord);
+            std::sort(bwd.begin(), bwd.end(), by_ord);
+            std::vector<int> positions;
+            for (int x : bwd) { positions.push_back(ord[x]); }
+            for (int x : fwd) { positions.push_back(ord[x]); }
+            std::sort(positions.begin(), positions.end());
+            bwd.insert(bwd.end(), fwd.begin(), fwd.end());
+            for (int i = 0; i < (int)bwd.size(); i++) {
+                ord[bwd[i]] = positions[i];
+                slot[positions[i]] = bwd[i];
+            }
+        }
+        out[a].push_back(b);
+        in[b].push_back(a);
+        return true;
+    }
+
+    int position(const NodeT& node) const {
+        /* Index of node in the current order, or -1 if it is unknown. */
+        auto it = ids.find(node);
+        return it == ids.end() ? -1 : ord[it->second];
+    }
+
+    std::vector<NodeT> order() const {
+        std::vector<NodeT> result;
+        for (int v : slot) { result.push_back(nodes[v]); }
+        return result;
     }
 };
 
@@ -342,7 +875,376 @@ void test_string_nodes() {
     assert(!ts.has_cycle());
 }
 
-int main() {
+void test_execute_respects_dependencies() {
+    std::mt19937 rng(5);
+    int n = 300;
+    TopologicalSort<int> ts;
+    std::vector<std::vector<int>> preds(n);
+    for (int i = 0; i < 1200; i++) {
+        int u = rng() % n, v = rng() % n;
+        if (u == v) { continue; }
+        if (u > v) { std::swap(u, v); }
+        ts.add_edge(u, v);
+        preds[v].push_back(u);
+    }
+    for (int threads : {1, 2, 4}) {
+        std::vector<std::atomic<int>> runs(n);
+        auto report = ts.execute(
+            [&](int v) {
+                for (int u : preds[v]) { assert(runs[u] == 1); }
+                runs[v]++;
+            },
+            threads);
+        for (int v : report.nodes) { assert(runs[v] == 1); }
+        assert(report.nodes.size() == report.duration_ms.size());
+    }
+}
+
+void test_execute_critical_path() {
+    TopologicalSort<std::string> ts;
+    ts.add_edge("fetch", "compile");
+    ts.add_edge("compile", "link");
+    ts.add_edge("fetch", "docs");
+    ts.add_edge("docs", "link");
+    auto report = ts.execute(
+        [](const std::string& node) {
+            if (node != "docs") { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+        },
+        2);
+    std::vector<std::string> expected = {"fetch", "compile", "link"};
+    assert(report.critical_path == expected);
+}
+
+void test_execute_cycle_and_errors() {
+    TopologicalSort<int> cyclic;
+    cyclic.add_edge(1, 2);
+    cyclic.add_edge(2, 1);
+    cyclic.add_edge(0, 1);
+    int calls = 0;
+    bool caught = false;
+    try {
+        cyclic.execute([&](int) { calls++; });
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught && calls == 0);
+
+    TopologicalSort<int> ts;
+    ts.add_edge(1, 2);
+    ts.add_edge(2, 3);
+    std::atomic<int> ran{0};
+    caught = false;
+    try {
+        ts.execute(
+            [&](int v) {
+                ran++;
+                if (v == 2) { throw std::logic_error("task failed"); }
+            },
+            3);
+    } catch (const std::logic_error&) { caught = true; }
+    assert(caught && ran == 2);  // Task 3 depends on the failed task and never runs
+
+    for (int iter = 0; iter < 2000; iter++) {
+        std::atomic<bool> third{false};
+        try {
+            ts.execute(
+                [&](int v) {
+                    if (v == 2) { throw std::logic_error("task failed"); }
+                    if (v == 3) { third = true; }
+                },
+                8);
+        } catch (const std::logic_error&) {}
+        assert(!third);
+    }
+}
+
+void test_dynamic_order() {
+    DynamicTopologicalOrder<std::string> order;
+    assert(order.add_edge("link", "test"));
+    assert(order.add_edge("compile", "link"));
+    assert(order.add_edge("fetch", "compile"));
+    std::vector<std::string> expected = {"fetch", "compile", "link", "test"};
+    assert(order.order() == expected);
+    assert(!order.add_edge("test", "fetch"));  // Would close a cycle: rejected
+    assert(!order.add_edge("link", "link"));
+    assert(order.order() == expected);
+    assert(order.position("compile") == 1 && order.position("deploy") == -1);
+}
+
+void test_dynamic_order_random() {
+    std::mt19937 rng(9);
+    for (int iter = 0; iter < 20; iter++) {
+        int n = 20 + iter * 10;
+        DynamicTopologicalOrder<int> order;
+        std::vector<std::vector<int>> adj(n);
+        std::vector<std::pair<int, int>> accepted;
+        for (int i = 0; i < 4 * n; i++) {
+            int u = rng() % n, v = rng() % n;
+            // Rejected exactly when v already reaches u
+            std::vector<bool> seen(n, false);
+            std::vector<int> todo = {v};
+            seen[v] = true;
+            while (!todo.empty()) {
+                int x = todo.back();
+                todo.pop_back();
+                for (int y : adj[x]) {
+                    if (!seen[y]) {
+                        seen[y] = true;
+                        todo.push_back(y);
+                    }
+                }
+            }
+            bool ok = order.add_edge(u, v);
+            assert(ok == !seen[u]);
+            if (ok) {
+                adj[u].push_back(v);
+                accepted.push_back({u, v});
+            }
+            for (const auto& [x, y] : accepted) { assert(order.position(x) < order.position(y)); }
+        }
+        auto result = order.order();
+        for (int i = 0; i < (int)result.size(); i++) { assert(order.position(result[i]) == i); }
+    }
+}
+
+void test_weighted_longest_path() {
+    TopologicalSort<std::string> ts;
+    ts.add_edge("fetch", "compile", 1);
+    ts.add_edge("compile", "link");
+    ts.add_edge("fetch", "docs");
+    ts.add_edge("docs", "link", 2);
+    ts.set_weight("fetch", 2);
+    ts.set_weight("compile", 10);
+    ts.set_weight("docs", 4);
+    ts.set_weight("link", 3);
+
+    auto paths = ts.weighted_longest_path();
+    std::vector<std::string> expected = {"fetch", "compile", "link"};
+    assert(paths.critical_path() == expected);
+    assert(paths.dist[paths.best] == 2 + 1 + 10 + 3);
+    int docs = std::find(paths.nodes.begin(), paths.nodes.end(), "docs") - paths.nodes.begin();
+    expected = {"fetch", "docs"};
+    assert(paths.path_to(docs) == expected && paths.dist[docs] == 6);
+
+    // Unit weights: agrees with longest_path, counting nodes instead of edges
+    TopologicalSort<int> unit;
+    for (int i = 0; i < 30; i++) {
+        unit.add_edge(i, (i * 7 + 3) % 31 > i ? (i * 7 + 3) % 31 : i + 1);
+        unit.add_edge(i, i + 2);
+    }
+    auto dist = unit.longest_path();
+    auto weighted = unit.weighted_longest_path();
+    for (int i = 0; i < (int)weighted.nodes.size(); i++) {
+        assert(weighted.dist[i] == dist[weighted.nodes[i]] + 1);
+        assert((int)weighted.path_to(i).size() == weighted.dist[i]);
+    }
+
+    // A negative edge is skipped by starting the path after it
+    TopologicalSort<int> negative;
+    negative.add_edge(1, 2, -5);
+    auto paths_negative = negative.weighted_longest_path();
+    assert(paths_negative.dist[1] == 1 && paths_negative.path_to(1) == std::vector<int>({2}));
+}
+
+void test_levels() {
+    TopologicalSort<int> ts;
+    std::vector<std::pair<int, int>> edges = {{5, 2}, {5, 0}, {4, 0}, {4, 1}, {2, 3}, {3, 1}};
+    for (const auto& [u, v] : edges) { ts.add_edge(u, v); }
+    auto levels = ts.levels();
+    std::vector<int> expected_nodes = {4, 5, 2, 0, 3, 1}, expected_offsets = {0, 2, 4, 5, 6};
+    assert(levels.nodes == expected_nodes && levels.offsets == expected_offsets);
+
+    auto dist = ts.longest_path();
+    for (int k = 0; k + 1 < (int)levels.offsets.size(); k++) {
+        for (int i = levels.offsets[k]; i < levels.offsets[k + 1]; i++) {
+            assert(dist[levels.nodes[i]] == k);
+        }
+    }
+
+    TopologicalSort<int> cyclic;
+    cyclic.add_edge(1, 2);
+    cyclic.add_edge(2, 1);
+    bool caught = false;
+    try {
+        cyclic.levels();
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+}
+
+void test_lexicographic_sort() {
+    TopologicalSort<int> ts;
+    std::vector<std::pair<int, int>> edges = {{5, 2}, {5, 0}, {4, 0}, {4, 1}, {2, 3}, {3, 1}};
+    for (const auto& [u, v] : edges) { ts.add_edge(u, v); }
+    std::vector<int> expected = {4, 5, 0, 2, 3, 1};
+    assert(ts.lexicographic_sort().value() == expected);
+
+    ts.add_node(-1);  // Isolated node
+    expected.insert(expected.begin(), -1);
+    assert(ts.lexicographic_sort().value() == expected);
+    assert(ts.kahn_sort().value().size() == 7 && ts.dfs_sort().value().size() == 7);
+
+    ts.add_edge(1, 4);
+    assert(!ts.lexicographic_sort().has_value());
+}
+
+void test_deep_dfs() {
+    // The DFS descends 10^6 levels, well past any recursion limit
+    int n = 1000000;
+    TopologicalSort<int> ts;
+    for (int i = n - 1; i > 0; i--) { ts.add_edge(i - 1, i); }
+    auto result = ts.dfs_sort();
+    assert(result.has_value() && (int)result->size() == n);
+    for (int i = 0; i < n; i++) { assert((*result)[i] == i); }
+    ts.add_edge(n - 1, 0);
+    assert(!ts.dfs_sort().has_value() && ts.has_cycle());
+}
+
+void test_random_orders_are_valid() {
+    std::mt19937 rng(3);
+    for (int iter = 0; iter < 50; iter++) {
+        int n = 1 + rng() % 60;
+        TopologicalSort<int> ts;
+        std::vector<std::pair<int, int>> edges;
+        for (int i = 0; i < 2 * n; i++) {
+            int u = rng() % n, v = rng() % n;
+            if (u == v) { continue; }
+            if (u > v) { std::swap(u, v); }
+            ts.add_edge(u, v);
+            edges.push_back({u, v});
+        }
+        for (const auto& order : {ts.kahn_sort(), ts.dfs_sort(), ts.lexicographic_sort()}) {
+            std::map<int, int> pos;
+            for (int i = 0; i < (int)order->size(); i++) { pos[(*order)[i]] = i; }
+            for (const auto& [u, v] : edges) { assert(pos[u] < pos[v]); }
+        }
+        // Smallest available node first, checked greedily against the constraints
+        auto lex = ts.lexicographic_sort().value();
+        std::vector<int> sorted = lex;
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<bool> done(n, false);
+        for (int v : lex) {
+            for (int w : sorted) {
+                if (done[w] || w == v) { continue; }
+                bool ready = true;
+                for (const auto& [a, b] : edges) { ready = ready && !(b == w && !done[a]); }
+                if (ready) { assert(w > v); }
+            }
+            done[v] = true;
+        }
+    }
+}
+
+void test_transitive_reduction() {
+    TopologicalSort<std::string> ts;
+    ts.add_edge("a", "b");
+    ts.add_edge("b", "c");
+    ts.add_edge("a", "c");  // Implied by a -> b -> c
+    ts.add_edge("a", "d");
+    ts.add_edge("c", "d");  // Makes a -> d redundant too
+    ts.add_edge("b", "c");  // Duplicate
+    auto reduced = ts.transitive_reduction();
+    std::vector<std::string> expected_nodes = {"a", "b", "c", "d"};
+    std::vector<int> expected_offsets = {0, 1, 2, 3, 3}, expected_targets = {1, 2, 3};
+    assert(reduced.nodes == expected_nodes);
+    assert(reduced.offsets == expected_offsets && reduced.targets == expected_targets);
+
+    TopologicalSort<int> cyclic;
+    cyclic.add_edge(1, 2);
+    cyclic.add_edge(2, 1);
+    bool caught = false;
+    try {
+        cyclic.transitive_reduction();
+    } catch (const std::runtime_error&) { caught = true; }
+    assert(caught);
+}
+
+void test_transitive_reduction_random() {
+    std::mt19937 rng(13);
+    for (int iter = 0; iter < 30; iter++) {
+        int n = 2 + rng() % 150;
+        TopologicalSort<int> ts;
+        std::vector<std::vector<bool>> reach(n, std::vector<bool>(n, false));
+        std::set<std::pair<int, int>> edges;
+        for (int i = 0; i < 4 * n; i++) {
+            int u = rng() % n, v = rng() % n;
+            if (u == v) { continue; }
+            if (u > v) { std::swap(u, v); }
+            // Relabel so NodeT order differs from topological order
+            ts.add_edge(n - 1 - u, n - 1 - v);
+            edges.insert({u, v});
+        }
+        for (int u = n - 1; u >= 0; u--) {
+            for (const auto& [a, b] : edges) {
+                if (a != u) { continue; }
+                reach[u][b] = true;
+                for (int w = 0; w < n; w++) { reach[u][w] = reach[u][w] || reach[b][w]; }
+            }
+        }
+        std::set<std::pair<int, int>> expected;  // u -> v kept iff no other child reaches v
+        for (const auto& [u, v] : edges) {
+            bool implied = false;
+            for (const auto& [a, b] : edges) {
+                implied = implied || (a == u && b != v && reach[b][v]);
+            }
+            if (!implied) { expected.insert({u, v}); }
+        }
+
+        for (size_t budget : {size_t(1) << 28, size_t(8)}) {  // One block, and one word per block
+            auto reduced = ts.transitive_reduction(budget);
+            std::set<std::pair<int, int>> actual;
+            for (int i = 0; i + 1 < (int)reduced.offsets.size(); i++) {
+                for (int e = reduced.offsets[i]; e < reduced.offsets[i + 1]; e++) {
+                    int u = n - 1 - reduced.nodes[i], v = n - 1 - reduced.nodes[reduced.targets[e]];
+                    assert(actual.insert({u, v}).second);
+                }
+            }
+            assert(actual == expected);
+        }
+    }
+}
+
+void benchmark(int n) {
+    // Run with: ./topological_sort bench [nodes]
+    std::mt19937 rng(1);
+    TopologicalSort<int> ts;
+    for (int i = 1; i < n; i++) {
+        ts.add_edge(rng() % i, i);
+        ts.add_edge(rng() % i, i);
+    }
+    auto time_ms = [](auto&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    };
+    std::cout << "freeze + kahn ms\t" << time_ms([&] { ts.kahn_sort(); }) << std::endl;
+    std::cout << "kahn ms\t" << time_ms([&] { ts.kahn_sort(); }) << std::endl;
+    std::cout << "dfs ms\t" << time_ms([&] { ts.dfs_sort(); }) << std::endl;
+    std::cout << "lexicographic ms\t" << time_ms([&] { ts.lexicographic_sort(); }) << std::endl;
+
+    // Transitive reduction: 10^5 nodes, 10 random edges to earlier nodes each
+    TopologicalSort<int> dag;
+    for (int i = 1; i < 100000; i++) {
+        for (int k = 0; k < 10; k++) { dag.add_edge(rng() % i, i); }
+    }
+    std::cout << "reduction ms\t" << time_ms([&] { dag.transitive_reduction(); }) << std::endl;
+
+    // execute(): three workers idle while one task sleeps; spinning would burn CPU time
+    TopologicalSort<int> chain;
+    chain.add_edge(1, 2);
+    std::clock_t cpu = std::clock();
+    auto report = chain.execute(
+        [](int v) {
+            if (v == 1) { std::this_thread::sleep_for(std::chrono::milliseconds(300)); }
+        },
+        4);
+    std::cout << "execute wall ms\t" << report.wall_ms << std::endl;
+    std::cout << "execute cpu ms\t" << 1000.0 * (std::clock() - cpu) / CLOCKS_PER_SEC << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark(argc > 2 ? std::stoi(argv[2]) : 10000000);
+        return 0;
+    }
     test_empty_graph();
     test_single_node_self_loop();
     test_linear_chain();
@@ -355,6 +1257,18 @@ int main() {
     test_comparison_kahn_vs_dfs();
     test_large_graph();
     test_string_nodes();
+    test_execute_respects_dependencies();
+    test_execute_critical_path();
+    test_execute_cycle_and_errors();
+    test_dynamic_order();
+    test_dynamic_order_random();
+    test_weighted_longest_path();
+    test_levels();
+    test_lexicographic_sort();
+    test_deep_dfs();
+    test_random_orders_are_valid();
+    test_transitive_reduction();
+    test_transitive_reduction_random();
     test_main();
     std::cout << "All Topological Sort tests passed!" << std::endl;
     return 0;
@@ -1,85 +1,491 @@
 /*
-2-SAT solver using Kosaraju's SCC algorithm on implication graph.
+2-SAT solver using Tarjan's SCC algorithm on the implication graph.
 
 2-SAT determines if a Boolean formula in CNF with at most 2 literals per clause is satisfiable.
 
-Time complexity: O(n + m) where n is variables and m is clauses.
+Clauses are collected in a flat list and frozen into one CSR (compressed sparse row) implication
+graph at solve time. A single iterative Tarjan pass finds the components, so no transpose graph
+is stored and deep implication chains cannot overflow the call stack.
+
+Incremental use: clauses added before the first push() form the base, which is solved once and
+cached. push()/pop() open and drop groups of extra clauses, and solve_under(assumptions) forces
+literals on top. Both are handled by unit propagation from the base assignment: a literal whose
+propagation ends without conflict can always be committed (Even, Itai and Shamir), so each
+scenario only touches the implications reachable from its assumptions and extra clauses.
+
+add_at_most_one uses the sequential (ladder) encoding: with auxiliaries s_i = "one of l_0..l_i
+is true", it needs 3k clauses and k - 1 new variables instead of k(k - 1) / 2 pairwise clauses.
+Auxiliary variables are numbered after the existing ones and appear in returned assignments.
+
+backbone() finds the literals true in every model. In a satisfiable formula, l is forced exactly
+when !l implies l, so these are read from the transitive closure of the condensation, computed
+as bitsets in reverse topological order. Only components true in the base model can be targets,
+since true literals imply only true literals; target columns are processed in blocks to bound
+memory.
+
+solve_batch solves many small independent instances packed into one clause buffer. Worker threads
+claim chunks of instances, each with its own reusable ImplicationGraph, and write assignments
+into one shared bitset, so no per-instance allocations happen once the scratch has grown.
+
+Time complexity: O(n + m) where n is variables and m is clauses. A scenario costs the
+propagated region plus O(n / 64) to copy the base assignment. backbone() costs O(C * D / 64)
+for C components and D condensation edges.
 Space complexity: O(n + m) for the implication graph.
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
+struct Backbone {
+    int witness = -1;  // If unsatisfiable: a variable whose two literals share a component
+    // (variable, negated) literals true in every model
+    std::vector<std::pair<int, bool>> forced;
+};
+
+struct ImplicationGraph {
+    /*
+    CSR implication graph with an iterative Tarjan pass. All arrays are reused across builds, so
+    a warmed-up instance solves further formulas without allocating.
+    */
+    std::vector<int> offsets, targets;  // Implications of node u are targets[offsets[u]..]
+    std::vector<int> comp;              // Component per node, in reverse topological order
+    std::vector<int> index, low, edge_pos, stack, call;
+
+    void build(int nodes, const std::pair<int, int>* clauses, int count) {
+        /* Clause (a or b) gives the implications !a -> b and !b -> a. */
+        offsets.assign(nodes + 1, 0);
+        for (int i = 0; i < count; i++) {
+            auto [a, b] = clauses[i];
+            offsets[(a ^ 1) + 1]++;
+            offsets[(b ^ 1) + 1]++;
+        }
+        for (int i = 0; i < nodes; i++) { offsets[i + 1] += offsets[i]; }
+        targets.resize(2 * count);
+        edge_pos.assign(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < count; i++) {
+            auto [a, b] = clauses[i];
+            targets[edge_pos[a ^ 1]++] = b;
+            targets[edge_pos[b ^ 1]++] = a;
+        }
+    }
+
+    void tarjan() {
+        int nodes = offsets.size() - 1;
+        index.assign(nodes, -1);
+        low.resize(nodes);
+        edge_pos.resize(nodes);
+        comp.assign(nodes, -1);
+        int counter = 0, components = 0;
+
+        for (int root = 0; root < nodes; root++) {
+            if (index[root] != -1) { continue; }
+            call.push_back(root);
+            index[root] = low[root] = counter++;
+            edge_pos[root] = offsets[root];
+            stack.push_back(root);
+
+            while (!call.empty()) {
+                int v = call.back();
+                if (edge_pos[v] < offsets[v + 1]) {
+                    int w = targets[edge_pos[v]++];
+                    if (index[w] == -1) {  // Tree edge: descend
+                        index[w] = low[w] = counter++;
+                        edge_pos[w] = offsets[w];
+                        stack.push_back(w);
+                        call.push_back(w);
+                    } else if (comp[w] == -1) {  // w is still on the stack
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+
+                call.pop_back();
+                if (!call.empty()) { low[call.back()] = std::min(low[call.back()], low[v]); }
+                if (low[v] == index[v]) {  // v is the root: pop its component off the stack
+                    int w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        comp[w] = components;
+                    } while (w != v);
+                    components++;
+                }
+            }
+        }
+    }
+};
+
 class TwoSAT {
   private:
     int n;
-    std::vector<std::vector<int>> graph;
-    std::vector<std::vector<int>> transpose;
+    std::vector<std::pair<int, int>> clauses;  // Literal nodes; node 2x is x, 2x + 1 is !x
+    ImplicationGraph graph;
+
+    std::vector<int> groups;  // Index in clauses where each pushed group starts
+    int base_clauses = -1;    // Clauses covered by the cached base solve, -1 if none
+    std::vector<bool> base;   // Base assignment, empty if the base is unsatisfiable
+    std::vector<char> truth;  // truth[u]: literal u is set by the current scenario
+    std::vector<int> trail;   // Literals set by the current scenario, in order
+    // Implications of the pushed groups, sorted by source literal
+    std::vector<std::pair<int, int>> delta;
+
+    void solve_base() {
+        int count = groups.empty() ? clauses.size() : groups[0];
+        if (count == base_clauses) { return; }
+        graph.build(2 * n, clauses.data(), count);
+        graph.tarjan();
+        const auto& comp = graph.comp;
+        base_clauses = count;
+        truth.assign(2 * n, 0);
+
+        base.clear();
+        for (int i = 0; i < n; i++) {
+            if (comp[2 * i] == comp[2 * i + 1]) { return; }
+        }
+
+        // Tarjan numbers components in reverse topological order, so x is true when its
+        // component comes later in topological order than that of !x
+        base.resize(n);
+        for (int i = 0; i < n; i++) { base[i] = comp[2 * i] < comp[2 * i + 1]; }
+    }
 
-    void dfs1(int node, std::vector<bool>& visited, std::vector<int>& finish_order) {
-        visited[node] = true;
-        for (int neighbor : graph[node]) {
-            if (!visited[neighbor]) { dfs1(neighbor, visited, finish_order); }
+    bool propagate(int lit) {
+        /* Set lit and everything it implies; false on conflict (the caller undoes the trail). */
+        if (truth[lit]) { return true; }
+        if (truth[lit ^ 1]) { return false; }
+        size_t head = trail.size();
+        truth[lit] = 1;
+        trail.push_back(lit);
+        auto visit = [&](int w) {
+            if (truth[w]) { return true; }
+            if (truth[w ^ 1]) { return false; }
+            truth[w] = 1;
+            trail.push_back(w);
+            return true;
+        };
+        while (head < trail.size()) {
+            int u = trail[head++];
+            for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++) {
+                if (!visit(graph.targets[e])) { return false; }
+            }
+            auto it = std::lower_bound(delta.begin(), delta.end(), std::make_pair(u, -1));
+            for (; it != delta.end() && it->first == u; it++) {
+                if (!visit(it->second)) { return false; }
+            }
         }
-        finish_order.push_back(node);
+        return true;
     }
 
-    void dfs2(int node, std::vector<bool>& visited, std::vector<int>& scc_id, int scc) {
-        visited[node] = true;
-        scc_id[node] = scc;
-        for (int neighbor : transpose[node]) {
-            if (!visited[neighbor]) { dfs2(neighbor, visited, scc_id, scc); }
+    void undo(size_t mark) {
+        while (trail.size() > mark) {
+            truth[trail.back()] = 0;
+            trail.pop_back();
         }
     }
 
+    bool scenario(const std::vector<std::pair<int, bool>>& assumptions) {
+        for (const auto& [x, neg] : assumptions) {
+            if (!propagate(2 * x + neg)) { return false; }
+        }
+
+        // Unassigned literals default to the base assignment, which satisfies every base clause
+        // and every propagated one; only group clauses it violates need a decision
+        int begin = groups.empty() ? clauses.size() : groups[0];
+        for (int i = begin; i < (int)clauses.size(); i++) {
+            auto [a, b] = clauses[i];
+            if (truth[a] || truth[b]) { continue; }
+            if (base[a >> 1] != (a & 1) || base[b >> 1] != (b & 1)) { continue; }
+            size_t mark = trail.size();
+            if (propagate(a)) { continue; }
+            undo(mark);
+            if (!propagate(b)) { return false; }
+        }
+        return true;
+    }
+
   public:
-    TwoSAT(int n) : n(n), graph(2 * n), transpose(2 * n) {}
+    TwoSAT(int n) : n(n) {}
 
     void add_clause(int a, bool a_neg, int b, bool b_neg) {
-        int a_node = 2 * a + (a_neg ? 1 : 0);
-        int b_node = 2 * b + (b_neg ? 1 : 0);
-        int na_node = 2 * a + (a_neg ? 0 : 1);
-        int nb_node = 2 * b + (b_neg ? 0 : 1);
+        clauses.push_back({2 * a + (a_neg ? 1 : 0), 2 * b + (b_neg ? 1 : 0)});
+    }
 
-        graph[na_node].push_back(b_node);
-        graph[nb_node].push_back(a_node);
-        transpose[b_node].push_back(na_node);
-        transpose[a_node].push_back(nb_node);
+    int new_variable() {
+        /* Append a fresh variable and return its index. */
+        base_clauses = -1;  // Per-node arrays must grow
+        return n++;
+    }
+
+    int num_variables() const {
+        return n;
+    }
+
+    void add_equal(int a, bool a_neg, int b, bool b_neg) {
+        /* Literal a and literal b take the same value. */
+        add_clause(a, !a_neg, b, b_neg);
+        add_clause(a, a_neg, b, !b_neg);
+    }
+
+    void add_xor(int a, bool a_neg, int b, bool b_neg) {
+        /* Exactly one of literal a and literal b is true. */
+        add_clause(a, a_neg, b, b_neg);
+        add_clause(a, !a_neg, b, !b_neg);
+    }
+
+    void add_at_most_one(const std::vector<std::pair<int, bool>>& literals) {
+        /* At most one of the (variable, negated) literals is true, in O(k) clauses. */
+        int k = literals.size();
+        if (k <= 4) {  // Pairwise is no larger here and needs no auxiliaries
+            for (int i = 0; i < k; i++) {
+                for (int j = i + 1; j < k; j++) {
+                    add_clause(literals[i].first, !literals[i].second, literals[j].first,
+                               !literals[j].second);
+                }
+            }
+            return;
+        }
+        int prev = -1;  // s_(i-1)
+        for (int i = 0; i < k; i++) {
+            auto [x, neg] = literals[i];
+            if (prev != -1) { add_clause(prev, true, x, !neg); }  // s_(i-1) -> !l_i
+            if (i == k - 1) { break; }
+            int s = new_variable();
+            add_clause(x, !neg, s, false);                         // l_i -> s_i
+            if (prev != -1) { add_clause(prev, true, s, false); }  // s_(i-1) -> s_i
+            prev = s;
+        }
+    }
+
+    void push() {
+        /* Open a clause group; clauses added until the matching pop() belong to it. */
+        groups.push_back(clauses.size());
+    }
+
+    void pop() {
+        /* Drop the clauses of the most recently pushed group. */
+        if (groups.empty()) { throw std::runtime_error("pop without matching push"); }
+        clauses.resize(groups.back());
+        groups.pop_back();
     }
 
     std::vector<bool> solve() {
-        std::vector<bool> visited(2 * n, false);
-        std::vector<int> finish_order;
+        return solve_under({});
+    }
+
+    std::vector<bool> solve_under(const std::vector<std::pair<int, bool>>& assumptions) {
+        /*
+        Solve the base clauses plus all open groups with each (variable, negated) assumption
+        forced true. Returns an empty vector if unsatisfiable.
+        */
+        solve_base();
+        if (base.empty() && n > 0) { return {}; }
 
-        for (int node = 0; node < 2 * n; node++) {
-            if (!visited[node]) { dfs1(node, visited, finish_order); }
+        delta.clear();
+        for (int i = groups.empty() ? clauses.size() : groups[0]; i < (int)clauses.size(); i++) {
+            auto [a, b] = clauses[i];
+            delta.push_back({a ^ 1, b});
+            delta.push_back({b ^ 1, a});
         }
+        std::sort(delta.begin(), delta.end());
 
-        std::fill(visited.begin(), visited.end(), false);
-        std::vector<int> scc_id(2 * n);
-        int current_scc = 0;
+        std::vector<bool> assignment;
+        if (scenario(assumptions)) {
+            assignment = base;
+            for (int lit : trail) { assignment[lit >> 1] = !(lit & 1); }
+        }
+        undo(0);
+        return assignment;
+    }
+
+    Backbone backbone(size_t max_bytes = 1 << 28) {
+        /*
+        Literals true in every model of the base clauses plus all open groups, sorted by
+        variable. Closure bitsets use at most about max_bytes at a time.
+        */
+        graph.build(2 * n, clauses.data(), clauses.size());
+        graph.tarjan();
+        const auto& comp = graph.comp;
+        const auto& offsets = graph.offsets;
+        const auto& targets = graph.targets;
+        base_clauses = -1;  // The CSR now includes the groups
+        Backbone result;
+        for (int i = 0; i < n; i++) {
+            if (comp[2 * i] == comp[2 * i + 1]) {
+                result.witness = i;
+                return result;
+            }
+        }
 
-        for (int i = finish_order.size() - 1; i >= 0; i--) {
-            int node = finish_order[i];
-            if (!visited[node]) {
-                dfs2(node, visited, scc_id, current_scc);
-                current_scc++;
+        // Condensation in CSR form; edges go from higher to lower component ids
+        int components = 0;
+        for (int c : comp) { components = std::max(components, c + 1); }
+        std::vector<int> by_comp(components + 1, 0), members(2 * n);
+        for (int c : comp) { by_comp[c + 1]++; }
+        for (int c = 0; c < components; c++) { by_comp[c + 1] += by_comp[c]; }
+        std::vector<int> pos(by_comp.begin(), by_comp.end() - 1);
+        for (int u = 0; u < 2 * n; u++) { members[pos[comp[u]]++] = u; }
+        std::vector<int> dag_offsets = {0}, dag_targets, seen(components, -1);
+        for (int c = 0; c < components; c++) {
+            for (int i = by_comp[c]; i < by_comp[c + 1]; i++) {
+                int u = members[i];
+                for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+                    int d = comp[targets[e]];
+                    if (d != c && seen[d] != c) {
+                        seen[d] = c;
+                        dag_targets.push_back(d);
+                    }
+                }
             }
+            dag_offsets.push_back(dag_targets.size());
         }
 
+        // Columns: components true in the model (smaller id than their complement), by id
+        std::vector<int> column(components, -1), columns_upto(components + 1, 0);
+        for (int u = 0; u < 2 * n; u++) {
+            if (comp[u] < comp[u ^ 1]) { column[comp[u]] = 0; }
+        }
+        int count = 0;
+        for (int c = 0; c < components; c++) {
+            if (column[c] != -1) { column[c] = count++; }
+            columns_upto[c + 1] = count;
+        }
+
+        // Candidates: false literals u, forced false iff u reaches !u
+        std::vector<int> candidates;
         for (int i = 0; i < n; i++) {
-            if (scc_id[2 * i] == scc_id[2 * i + 1]) { return {}; }
+            candidates.push_back(comp[2 * i] > comp[2 * i + 1] ? 2 * i : 2 * i + 1);
         }
+        std::sort(candidates.begin(), candidates.end(),
+                  [&](int a, int b) { return column[comp[a ^ 1]] < column[comp[b ^ 1]]; });
 
-        std::vector<bool> assignment(n);
-        for (int i = 0; i < n; i++) { assignment[i] = scc_id[2 * i] > scc_id[2 * i + 1]; }
+        int width = std::max<size_t>(1, max_bytes / (sizeof(uint64_t) * std::max(components, 1)));
+        std::vector<uint64_t> rows;
+        for (int i = 0; i < (int)candidates.size();) {
+            int lo = column[comp[candidates[i] ^ 1]];  // First column of the block
+            int first = std::lower_bound(columns_upto.begin() + 1, columns_upto.end(), lo + 1) -
+                        columns_upto.begin() - 1;  // Component of column lo
+            int words = std::min<long long>(width, (count - lo + 63) / 64);
+            rows.assign((size_t)(components - first) * words, 0);
+            for (int c = first; c < components; c++) {
+                uint64_t* row = &rows[(size_t)(c - first) * words];
+                int col = column[c] - lo;
+                if (column[c] != -1 && col < 64 * words) { row[col >> 6] |= 1ULL << (col & 63); }
+                for (int e = dag_offsets[c]; e < dag_offsets[c + 1]; e++) {
+                    int d = dag_targets[e];
+                    if (d < first) { continue; }
+                    // d reaches no column beyond its own id
+                    int limit = std::min(words, (columns_upto[d + 1] - lo + 63) / 64);
+                    const uint64_t* child = &rows[(size_t)(d - first) * words];
+                    for (int k = 0; k < limit; k++) { row[k] |= child[k]; }
+                }
+            }
+            for (; i < (int)candidates.size(); i++) {
+                int u = candidates[i], col = column[comp[u ^ 1]] - lo;
+                if (col >= 64 * words) { break; }
+                if (rows[(size_t)(comp[u] - first) * words + (col >> 6)] >> (col & 63) & 1) {
+                    result.forced.push_back({u >> 1, (u ^ 1) & 1});
+                }
+            }
+        }
+        std::sort(result.forced.begin(), result.forced.end());
+        return result;
+    }
+};
 
-        return assignment;
+struct TwoSATBatch {
+    /*
+    Independent instances packed contiguously. Instance i owns bits [var_offsets[i],
+    var_offsets[i + 1]) of the output bitset and clauses [clause_offsets[i],
+    clause_offsets[i + 1]), stored as literal nodes 2x + negated with x local to the instance.
+    */
+    std::vector<long long> var_offsets = {0}, clause_offsets = {0};
+    std::vector<std::pair<int, int>> clauses;
+
+    int add_instance(int variables) {
+        /* Start a new instance; following add_clause calls belong to it. */
+        var_offsets.push_back(var_offsets.back() + variables);
+        clause_offsets.push_back(clauses.size());
+        return size() - 1;
+    }
+
+    void add_clause(int a, bool a_neg, int b, bool b_neg) {
+        clauses.push_back({2 * a + (a_neg ? 1 : 0), 2 * b + (b_neg ? 1 : 0)});
+        clause_offsets.back() = clauses.size();
+    }
+
+    int size() const {
+        return var_offsets.size() - 1;
     }
 };
 
+void solve_batch(const TwoSATBatch& batch, std::vector<uint64_t>& assignment,
+                 std::vector<char>& satisfiable, int threads = 1) {
+    /*
+    Solve every instance. Bit var_offsets[i] + x of assignment is variable x of instance i (all
+    zero if unsatisfiable), and satisfiable[i] tells which. Outputs are only grown if too small.
+    */
+    int k = batch.size();
+    size_t words = (batch.var_offsets.back() + 63) / 64;
+    if (assignment.size() < words) { assignment.resize(words); }
+    if ((int)satisfiable.size() < k) { satisfiable.resize(k); }
+
+    constexpr int CHUNK = 64;  // Instances claimed at a time
+    std::atomic<int> next{0};
+    auto worker = [&] {
+        ImplicationGraph graph;
+        for (int start; (start = next.fetch_add(CHUNK)) < k;) {
+            for (int i = start; i < std::min(k, start + CHUNK); i++) {
+                int n = batch.var_offsets[i + 1] - batch.var_offsets[i];
+                long long first = batch.clause_offsets[i], last = batch.clause_offsets[i + 1];
+                graph.build(2 * n, batch.clauses.data() + first, last - first);
+                graph.tarjan();
+                const auto& comp = graph.comp;
+                bool ok = true;
+                for (int x = 0; x < n && ok; x++) { ok = comp[2 * x] != comp[2 * x + 1]; }
+                satisfiable[i] = ok;
+
+                // Write 64-bit pieces; words shared with neighbouring instances are updated
+                // atomically on this instance's bits only
+                for (int x = 0; x < n;) {
+                    long long bit = batch.var_offsets[i] + x;
+                    int shift = bit & 63, take = std::min(64 - shift, n - x);
+                    uint64_t value = 0;
+                    for (int j = 0; ok && j < take; j++) {
+                        int v = x + j;
+                        value |= (uint64_t)(comp[2 * v] < comp[2 * v + 1]) << (shift + j);
+                    }
+                    uint64_t& word = assignment[bit >> 6];
+                    if (take == 64) {
+                        word = value;
+                    } else {
+                        uint64_t mask = ((1ULL << take) - 1) << shift;
+                        std::atomic_ref<uint64_t> ref(word);
+                        ref.fetch_and(~mask, std::memory_order_relaxed);
+                        ref.fetch_or(value, std::memory_order_relaxed);
+                    }
+                    x += take;
+                }
+            }
+        }
+    };
+
+    if (threads <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) { pool.emplace_back(worker); }
+    for (auto& t : pool) { t.join(); }
+}
+
 void test_main() {
     TwoSAT sat(2);
     sat.add_clause(0, false, 1, false);
@@ -130,12 +536,253 @@ void test_xor_constraint() {
     assert((result[0] && !result[1]) || (!result[0] && result[1]));
 }
 
+bool satisfies(const std::vector<std::pair<int, int>>& clauses, const std::vector<bool>& x) {
+    for (const auto& [a, b] : clauses) {
+        if (x[a >> 1] == (a & 1) && x[b >> 1] == (b & 1)) { return false; }
+    }
+    return true;
+}
+
+bool brute_force_satisfiable(int n, const std::vector<std::pair<int, int>>& clauses) {
+    for (int mask = 0; mask < (1 << n); mask++) {
+        std::vector<bool> x(n);
+        for (int i = 0; i < n; i++) { x[i] = mask >> i & 1; }
+        if (satisfies(clauses, x)) { return true; }
+    }
+    return false;
+}
+
+void test_random_against_brute_force() {
+    std::mt19937 rng(7);
+    for (int iter = 0; iter < 500; iter++) {
+        int n = 1 + rng() % 8, m = rng() % (3 * n);
+        TwoSAT sat(n);
+        std::vector<std::pair<int, int>> clauses;  // Literals as 2x + negated
+        for (int i = 0; i < m; i++) {
+            int a = rng() % (2 * n), b = rng() % (2 * n);
+            sat.add_clause(a >> 1, a & 1, b >> 1, b & 1);
+            clauses.push_back({a, b});
+        }
+        auto result = sat.solve();
+        assert(result.empty() != brute_force_satisfiable(n, clauses));
+        if (!result.empty()) { assert(satisfies(clauses, result)); }
+    }
+}
+
+void test_long_implication_chain() {
+    // x0 -> x1 -> ... -> x(n-1), x0 forced: recursion would need a stack n frames deep
+    int n = 1000000;
+    TwoSAT sat(n);
+    for (int i = 0; i + 1 < n; i++) { sat.add_clause(i, true, i + 1, false); }
+    sat.add_clause(0, false, 0, false);
+    auto result = sat.solve();
+    assert((int)result.size() == n);
+    assert(std::all_of(result.begin(), result.end(), [](bool b) { return b; }));
+}
+
+void test_push_pop() {
+    TwoSAT sat(3);
+    sat.add_clause(0, true, 1, false);  // x0 -> x1
+    sat.add_clause(1, true, 2, false);  // x1 -> x2
+    assert(!sat.solve().empty());
+
+    sat.push();
+    sat.add_clause(0, false, 0, false);  // x0
+    sat.add_clause(2, true, 2, true);    // !x2
+    assert(sat.solve().empty());
+    sat.pop();
+
+    sat.push();
+    sat.add_clause(0, false, 0, false);
+    auto result = sat.solve();
+    assert(result[0] && result[1] && result[2]);
+    sat.push();
+    sat.add_clause(2, true, 1, true);  // !x2 or !x1
+    assert(sat.solve().empty());
+    sat.pop();
+    sat.pop();
+
+    result = sat.solve_under({{2, true}});  // Assume !x2
+    assert(!result.empty() && !result[0] && !result[1] && !result[2]);
+    assert(sat.solve_under({{2, true}, {0, false}}).empty());
+    assert(!sat.solve().empty());  // Assumptions do not persist
+
+    bool threw = false;
+    try {
+        sat.pop();
+    } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+void test_incremental_against_brute_force() {
+    std::mt19937 rng(11);
+    for (int iter = 0; iter < 300; iter++) {
+        int n = 1 + rng() % 8;
+        TwoSAT sat(n);
+        std::vector<std::pair<int, int>> clauses;
+        auto add_random = [&](int count) {
+            for (int i = 0; i < count; i++) {
+                int a = rng() % (2 * n), b = rng() % (2 * n);
+                sat.add_clause(a >> 1, a & 1, b >> 1, b & 1);
+                clauses.push_back({a, b});
+            }
+        };
+        add_random(rng() % (2 * n));
+        for (int scenario = 0; scenario < 10; scenario++) {
+            size_t base_size = clauses.size();
+            sat.push();
+            add_random(rng() % 4);
+            std::vector<std::pair<int, bool>> assumptions;
+            auto with_units = clauses;
+            for (int k = rng() % 3; k > 0; k--) {
+                int lit = rng() % (2 * n);
+                assumptions.push_back({lit >> 1, lit & 1});
+                with_units.push_back({lit, lit});
+            }
+            auto result = sat.solve_under(assumptions);
+            assert(result.empty() != brute_force_satisfiable(n, with_units));
+            if (!result.empty()) { assert(satisfies(with_units, result)); }
+            sat.pop();
+            clauses.resize(base_size);
+        }
+    }
+}
+
+void test_equal_and_xor() {
+    TwoSAT sat(3);
+    sat.add_equal(0, false, 1, true);  // x0 == !x1
+    sat.add_xor(1, false, 2, false);   // x1 != x2
+    sat.add_clause(0, false, 0, false);
+    auto result = sat.solve();
+    assert(result[0] && !result[1] && result[2]);
+    assert(sat.solve_under({{2, true}}).empty());
+}
+
+void test_at_most_one() {
+    for (int k : {1, 2, 4, 5, 9}) {
+        for (int forced = 0; forced <= 2; forced++) {
+            TwoSAT sat(k);
+            std::vector<std::pair<int, bool>> literals;
+            for (int i = 0; i < k; i++) { literals.push_back({i, i % 3 == 1}); }
+            sat.add_at_most_one(literals);
+            assert(sat.num_variables() == (k <= 4 ? k : 2 * k - 1));
+
+            std::vector<std::pair<int, bool>> assumptions(literals.begin(),
+                                                          literals.begin() + std::min(forced, k));
+            auto result = sat.solve_under(assumptions);
+            assert(result.empty() == (std::min(forced, k) >= 2));
+            if (result.empty()) { continue; }
+            int count = 0;
+            for (auto [x, neg] : literals) { count += result[x] != neg; }
+            assert(count <= 1 && count >= std::min(forced, k));
+        }
+    }
+
+    // Every pair of a large group conflicts, via O(k) clauses
+    int k = 10000;
+    TwoSAT sat(k);
+    std::vector<std::pair<int, bool>> literals;
+    for (int i = 0; i < k; i++) { literals.push_back({i, false}); }
+    sat.add_at_most_one(literals);
+    sat.add_clause(k - 1, false, k - 1, false);
+    auto result = sat.solve();
+    assert(!result.empty() && result[k - 1] && !result[0] && !result[k / 2]);
+    assert(sat.solve_under({{0, false}}).empty());
+}
+
+void test_backbone() {
+    TwoSAT sat(4);
+    sat.add_clause(0, false, 0, false);  // x0
+    sat.add_clause(0, true, 1, true);    // x0 -> !x1
+    sat.add_clause(2, false, 3, false);  // x2 or x3: neither forced
+    Backbone b = sat.backbone();
+    std::vector<std::pair<int, bool>> expected = {{0, false}, {1, true}};
+    assert(b.witness == -1 && b.forced == expected);
+
+    sat.push();
+    sat.add_clause(1, false, 2, true);  // x1 or !x2, so !x2 and then x3
+    expected = {{0, false}, {1, true}, {2, true}, {3, false}};
+    assert(sat.backbone().forced == expected);
+    sat.add_clause(3, true, 3, true);
+    b = sat.backbone();
+    assert(b.witness != -1 && b.forced.empty());
+    sat.pop();
+    assert(!sat.solve().empty());
+}
+
+void test_backbone_against_brute_force() {
+    std::mt19937 rng(23);
+    for (int iter = 0; iter < 300; iter++) {
+        int n = 1 + rng() % 10, m = rng() % (2 * n);
+        TwoSAT sat(n);
+        std::vector<std::pair<int, int>> clauses;
+        for (int i = 0; i < m; i++) {
+            int a = rng() % (2 * n), b = rng() % (2 * n);
+            sat.add_clause(a >> 1, a & 1, b >> 1, b & 1);
+            clauses.push_back({a, b});
+        }
+        std::vector<std::pair<int, bool>> expected;
+        for (int lit = 0; lit < 2 * n; lit++) {
+            auto with_unit = clauses;
+            with_unit.push_back({lit ^ 1, lit ^ 1});
+            if (!brute_force_satisfiable(n, with_unit)) { expected.push_back({lit >> 1, lit & 1}); }
+        }
+        bool sat_ok = brute_force_satisfiable(n, clauses);
+        for (size_t budget : {size_t(1) << 28, size_t(8)}) {  // One block, and one word per block
+            Backbone b = sat.backbone(budget);
+            assert((b.witness == -1) == sat_ok);
+            if (sat_ok) { assert(b.forced == expected); }
+        }
+    }
+}
+
+void test_batch_matches_single() {
+    std::mt19937 rng(31);
+    TwoSATBatch batch;
+    std::vector<std::vector<bool>> expected;
+    for (int i = 0; i < 3000; i++) {
+        int n = rng() % 100, m = n == 0 ? 0 : rng() % (2 * n);
+        batch.add_instance(n);
+        TwoSAT sat(n);
+        for (int j = 0; j < m; j++) {
+            int a = rng() % (2 * n), b = rng() % (2 * n);
+            batch.add_clause(a >> 1, a & 1, b >> 1, b & 1);
+            sat.add_clause(a >> 1, a & 1, b >> 1, b & 1);
+        }
+        expected.push_back(sat.solve());
+    }
+
+    for (int threads : {1, 2, 4}) {
+        std::vector<uint64_t> bits(1, ~0ULL);  // Too small and dirty: must be grown and cleared
+        std::vector<char> ok;
+        solve_batch(batch, bits, ok, threads);
+        for (int i = 0; i < batch.size(); i++) {
+            int n = batch.var_offsets[i + 1] - batch.var_offsets[i];
+            assert(ok[i] == (!expected[i].empty() || n == 0));
+            for (int x = 0; x < n; x++) {
+                long long bit = batch.var_offsets[i] + x;
+                bool value = bits[bit >> 6] >> (bit & 63) & 1;
+                assert(value == (ok[i] && expected[i][x]));
+            }
+        }
+    }
+}
+
 int main() {
     test_main();
     test_unsatisfiable();
     test_single_variable();
     test_implication_chain();
     test_xor_constraint();
+    test_random_against_brute_force();
+    test_long_implication_chain();
+    test_push_pop();
+    test_incremental_against_brute_force();
+    test_equal_and_xor();
+    test_at_most_one();
+    test_backbone();
+    test_backbone_against_brute_force();
+    test_batch_matches_single();
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }